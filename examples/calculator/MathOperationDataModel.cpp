@@ -25,6 +25,25 @@ std::shared_ptr<NodeData> MathOperationDataModel::outData(PortIndex)
 }
 
 void MathOperationDataModel::setInData(std::shared_ptr<NodeData> data, PortIndex portIndex)
+{
+    storeInput(data, portIndex);
+
+    compute();
+}
+
+void MathOperationDataModel::setInDataBatch(
+    std::vector<std::pair<PortIndex, std::shared_ptr<NodeData>>> const &inputs)
+{
+    // Both operands may arrive in the same tick, compute the result once.
+    for (auto const &input : inputs) {
+        storeInput(input.second, input.first);
+    }
+
+    compute();
+}
+
+void MathOperationDataModel::storeInput(std::shared_ptr<NodeData> const &data,
+                                        PortIndex portIndex)
 {
     auto numberData = std::dynamic_pointer_cast<DecimalData>(data);
 
@@ -37,6 +56,4 @@ void MathOperationDataModel::setInData(std::shared_ptr<NodeData> data, PortIndex
     } else {
         _number2 = numberData;
     }
-
-    compute();
 }
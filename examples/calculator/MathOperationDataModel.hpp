@@ -34,11 +34,17 @@ public:
 
     void setInData(std::shared_ptr<NodeData> data, PortIndex portIndex) override;
 
+    void setInDataBatch(
+        std::vector<std::pair<PortIndex, std::shared_ptr<NodeData>>> const &inputs) override;
+
     QWidget *embeddedWidget() override { return nullptr; }
 
 protected:
     virtual void compute() = 0;
 
+private:
+    void storeInput(std::shared_ptr<NodeData> const &data, PortIndex portIndex);
+
 protected:
     std::weak_ptr<DecimalData> _number1;
     std::weak_ptr<DecimalData> _number2;
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "DecimalData.hpp"
+
+#include <QtNodes/NodeDelegateModel>
+
+#include <cstdint>
+
+using QtNodes::CancellationToken;
+using QtNodes::NodeData;
+using QtNodes::NodeDataType;
+using QtNodes::NodeDelegateModel;
+using QtNodes::PortIndex;
+using QtNodes::PortType;
+
+/// Counts the primes not greater than the input number on a worker thread.
+/// Editing the source number while a large count is running cancels it and
+/// only the count for the newest number is delivered downstream.
+class PrimeCountModel : public NodeDelegateModel
+{
+public:
+    ~PrimeCountModel() = default;
+
+public:
+    QString caption() const override { return QStringLiteral("Prime Count"); }
+
+    QString name() const override { return QStringLiteral("PrimeCount"); }
+
+public:
+    unsigned int nPorts(PortType) const override { return 1; }
+
+    NodeDataType dataType(PortType, PortIndex) const override { return DecimalData().type(); }
+
+    std::shared_ptr<NodeData> outData(PortIndex port) override { return computedOutData(port); }
+
+    void setInData(std::shared_ptr<NodeData> data, PortIndex) override
+    {
+        auto numberData = std::dynamic_pointer_cast<DecimalData>(data);
+
+        if (!numberData) {
+            cancelCompute();
+            setComputedOutData({{0, nullptr}});
+            return;
+        }
+
+        // The inputs are captured by value, the model is never touched there.
+        double const limit = numberData->number();
+
+        computeAsync([limit](CancellationToken const &token) -> PortDataList {
+            std::int64_t count = 0;
+
+            for (std::int64_t n = 2; n <= limit; ++n) {
+                if ((n & 0xfff) == 0 && token.isCancelled())
+                    return {};
+
+                bool prime = true;
+                for (std::int64_t d = 2; d * d <= n && prime; ++d) {
+                    prime = (n % d) != 0;
+                }
+
+                count += prime ? 1 : 0;
+            }
+
+            return {{0, std::make_shared<DecimalData>(static_cast<double>(count))}};
+        });
+    }
+
+    QWidget *embeddedWidget() override { return nullptr; }
+};
@@ -3,6 +3,7 @@
 #include "MultiplicationModel.hpp"
 #include "NumberDisplayDataModel.hpp"
 #include "NumberSourceDataModel.hpp"
+#include "PrimeCountModel.hpp"
 #include "SubtractionModel.hpp"
 
 #include <QtNodes/DataFlowGraphModel>
@@ -27,6 +28,8 @@ static std::shared_ptr<NodeDelegateModelRegistry> registerDataModels()
 
     ret->registerModel<DivisionModel>("Operators");
 
+    ret->registerModel<PrimeCountModel>("Operators");
+
     return ret;
 }
 
@@ -17,6 +17,7 @@
 #include "MultiplicationModel.hpp"
 #include "NumberDisplayDataModel.hpp"
 #include "NumberSourceDataModel.hpp"
+#include "PrimeCountModel.hpp"
 #include "SubtractionModel.hpp"
 
 using QtNodes::ConnectionStyle;
@@ -40,6 +41,8 @@ static std::shared_ptr<NodeDelegateModelRegistry> registerDataModels()
 
     ret->registerModel<DivisionModel>("Operators");
 
+    ret->registerModel<PrimeCountModel>("Operators");
+
     return ret;
 }
 
@@ -88,6 +91,9 @@ int main(int argc, char *argv[])
 
     DataFlowGraphModel dataFlowGraphModel(registry);
 
+    // Evaluate each node once per update even in diamond-shaped graphs.
+    dataFlowGraphModel.setPropagationMode(DataFlowGraphModel::PropagationMode::Batched);
+
     l->addWidget(menuBar);
     auto scene = new DataFlowGraphicsScene(dataFlowGraphModel, &mainWidget);
 
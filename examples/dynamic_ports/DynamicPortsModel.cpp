@@ -65,7 +65,7 @@ NodeId DynamicPortsModel::addNode(QString const nodeType)
     // Create new node.
     _nodeIds.insert(newId);
 
-    Q_EMIT nodeCreated(newId);
+    notifyNodeCreated(newId);
 
     return newId;
 }
@@ -79,7 +79,7 @@ void DynamicPortsModel::addConnection(ConnectionId const connectionId)
 {
     _connectivity.insert(connectionId);
 
-    Q_EMIT connectionCreated(connectionId);
+    notifyConnectionCreated(connectionId);
 }
 
 bool DynamicPortsModel::nodeExists(NodeId const nodeId) const
@@ -267,7 +267,7 @@ bool DynamicPortsModel::deleteConnection(ConnectionId const connectionId)
     };
 
     if (disconnected)
-        Q_EMIT connectionDeleted(connectionId);
+        notifyConnectionDeleted(connectionId);
 
     return disconnected;
 }
@@ -285,7 +285,7 @@ bool DynamicPortsModel::deleteNode(NodeId const nodeId)
     _nodePortCounts.erase(nodeId);
     _nodeWidgets.erase(nodeId);
 
-    Q_EMIT nodeDeleted(nodeId);
+    notifyNodeDeleted(nodeId);
 
     return true;
 }
@@ -352,7 +352,7 @@ void DynamicPortsModel::loadNode(QJsonObject const &nodeJson)
         setNodeData(restoredNodeId, NodeRole::Position, pos);
     }
 
-    Q_EMIT nodeCreated(restoredNodeId);
+    notifyNodeCreated(restoredNodeId);
 }
 
 void DynamicPortsModel::load(QJsonObject const &jsonDocument)
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QtNodes/NodeData>
+#include <QtNodes/NodeDelegateModel>
+
+#include <memory>
+
+using QtNodes::ConnectionPolicy;
+using QtNodes::NodeData;
+using QtNodes::NodeDataType;
+using QtNodes::NodeDelegateModel;
+using QtNodes::PortIndex;
+using QtNodes::PortType;
+
+class BenchmarkData : public NodeData
+{
+public:
+    NodeDataType type() const override { return NodeDataType{"benchmark", "Benchmark"}; }
+};
+
+/// A node without any computations. All the measured time is spent inside the
+/// graph model.
+class BenchmarkModel : public NodeDelegateModel
+{
+public:
+    BenchmarkModel()
+        : _data(std::make_shared<BenchmarkData>())
+    {
+        InPortCount = 4;
+        OutPortCount = 4;
+    }
+
+public:
+    QString caption() const override { return QStringLiteral("Benchmark"); }
+
+    QString name() const override { return QStringLiteral("Benchmark"); }
+
+public:
+    NodeDataType dataType(PortType, PortIndex) const override { return BenchmarkData().type(); }
+
+    ConnectionPolicy portConnectionPolicy(PortType, PortIndex) const override
+    {
+        return ConnectionPolicy::Many;
+    }
+
+    std::shared_ptr<NodeData> outData(PortIndex const) override { return _data; }
+
+    void setInData(std::shared_ptr<NodeData>, PortIndex const) override {}
+
+    QWidget *embeddedWidget() override { return nullptr; }
+
+private:
+    std::shared_ptr<NodeData> _data;
+};
@@ -0,0 +1,202 @@
+#include "BenchmarkModel.hpp"
+
+#include <QtNodes/ConnectionIdUtils>
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/NodeDelegateModelRegistry>
+
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonObject>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <unordered_set>
+#include <vector>
+
+using QtNodes::ConnectionId;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::NodeId;
+
+namespace {
+
+unsigned int const PortsPerNode = 4;
+
+unsigned int const SampledQueries = 1000;
+
+unsigned int const SampledDeletions = 100;
+
+/// Deterministic pseudo-random sequence, keeps the runs comparable.
+class Lcg
+{
+public:
+    unsigned int next(unsigned int bound)
+    {
+        _state = _state * 1664525u + 1013904223u;
+        return (_state >> 8) % bound;
+    }
+
+private:
+    std::uint32_t _state = 12345u;
+};
+
+struct PortQuery
+{
+    NodeId nodeId;
+    PortType portType;
+    PortIndex portIndex;
+};
+
+/// The way connections were looked up before the adjacency index existed.
+std::unordered_set<ConnectionId> linearScan(std::unordered_set<ConnectionId> const &connectivity,
+                                            PortQuery const &q)
+{
+    std::unordered_set<ConnectionId> result;
+
+    std::copy_if(connectivity.begin(),
+                 connectivity.end(),
+                 std::inserter(result, std::end(result)),
+                 [&q](ConnectionId const &cid) {
+                     return (QtNodes::getNodeId(q.portType, cid) == q.nodeId
+                             && QtNodes::getPortIndex(q.portType, cid) == q.portIndex);
+                 });
+
+    return result;
+}
+
+double microsecondsPerCall(qint64 const nsecs, unsigned int const calls)
+{
+    return static_cast<double>(nsecs) / 1000.0 / calls;
+}
+
+void runBenchmark(std::shared_ptr<NodeDelegateModelRegistry> registry,
+                  unsigned int const nConnections)
+{
+    DataFlowGraphModel model(registry);
+
+    Lcg rng;
+
+    unsigned int const nNodes = std::max(2u, nConnections / 8);
+
+    std::vector<NodeId> nodes;
+    nodes.reserve(nNodes);
+
+    for (unsigned int i = 0; i < nNodes; ++i) {
+        nodes.push_back(model.addNode(QStringLiteral("Benchmark")));
+    }
+
+    std::unordered_set<ConnectionId> connectivity;
+    connectivity.reserve(nConnections);
+
+    while (connectivity.size() < nConnections) {
+        NodeId const outNodeId = nodes[rng.next(nNodes)];
+        NodeId const inNodeId = nodes[rng.next(nNodes)];
+
+        if (outNodeId == inNodeId)
+            continue;
+
+        ConnectionId const cid{outNodeId,
+                               rng.next(PortsPerNode),
+                               inNodeId,
+                               rng.next(PortsPerNode)};
+
+        if (connectivity.insert(cid).second)
+            model.addConnection(cid);
+    }
+
+    std::vector<PortQuery> queries;
+    queries.reserve(SampledQueries);
+
+    for (unsigned int i = 0; i < SampledQueries; ++i) {
+        queries.push_back({nodes[rng.next(nNodes)],
+                           rng.next(2) ? PortType::Out : PortType::In,
+                           rng.next(PortsPerNode)});
+    }
+
+    QElapsedTimer timer;
+    std::size_t checksum = 0;
+
+    timer.start();
+    for (auto const &q : queries) {
+        checksum += linearScan(connectivity, q).size();
+    }
+    qint64 const scanTime = timer.nsecsElapsed();
+
+    timer.start();
+    for (auto const &q : queries) {
+        checksum -= model.connections(q.nodeId, q.portType, q.portIndex).size();
+    }
+    qint64 const indexedTime = timer.nsecsElapsed();
+
+    timer.start();
+    for (auto const &q : queries) {
+        checksum += model.connectionCount(q.nodeId, q.portType, q.portIndex);
+    }
+    qint64 const countTime = timer.nsecsElapsed();
+
+    timer.start();
+    for (auto const &q : queries) {
+        model.visitConnections(q.nodeId, q.portType, q.portIndex, [&checksum](ConnectionId const &) {
+            --checksum;
+        });
+    }
+    qint64 const visitTime = timer.nsecsElapsed();
+
+    Q_ASSERT(checksum == 0);
+
+    timer.start();
+    for (auto const &q : queries) {
+        Q_EMIT model.delegateModel<BenchmarkModel>(q.nodeId)->dataUpdated(q.portIndex);
+    }
+    qint64 const propagationTime = timer.nsecsElapsed();
+
+    timer.start();
+    for (unsigned int i = 0; i < SampledDeletions; ++i) {
+        model.deleteNode(nodes[i]);
+    }
+    qint64 const deletionTime = timer.nsecsElapsed();
+
+    QJsonObject const sceneJson = model.save();
+
+    timer.start();
+    {
+        DataFlowGraphModel loaded(registry);
+        loaded.load(sceneJson);
+    }
+    qint64 const loadTime = timer.nsecsElapsed();
+
+    qInfo().noquote() << QString("%1 connections, %2 nodes").arg(nConnections).arg(nNodes);
+    qInfo().noquote() << QString("  port query, linear scan:  %1 us")
+                             .arg(microsecondsPerCall(scanTime, SampledQueries), 0, 'f', 3);
+    qInfo().noquote() << QString("  port query, indexed:      %1 us (x%2)")
+                             .arg(microsecondsPerCall(indexedTime, SampledQueries), 0, 'f', 3)
+                             .arg(static_cast<double>(scanTime) / std::max<qint64>(indexedTime, 1),
+                                  0,
+                                  'f',
+                                  1);
+    qInfo().noquote() << QString("  port query, count:        %1 us")
+                             .arg(microsecondsPerCall(countTime, SampledQueries), 0, 'f', 3);
+    qInfo().noquote() << QString("  port query, visitor:      %1 us")
+                             .arg(microsecondsPerCall(visitTime, SampledQueries), 0, 'f', 3);
+    qInfo().noquote() << QString("  data propagation:         %1 us")
+                             .arg(microsecondsPerCall(propagationTime, SampledQueries), 0, 'f', 3);
+    qInfo().noquote() << QString("  node deletion:            %1 us")
+                             .arg(microsecondsPerCall(deletionTime, SampledDeletions), 0, 'f', 3);
+    qInfo().noquote() << QString("  scene load:               %1 ms")
+                             .arg(static_cast<double>(loadTime) / 1e6, 0, 'f', 2);
+}
+
+} // namespace
+
+int main()
+{
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<BenchmarkModel>("Benchmark");
+
+    for (unsigned int nConnections : {1000u, 10000u, 100000u}) {
+        runBenchmark(registry, nConnections);
+    }
+
+    return 0;
+}
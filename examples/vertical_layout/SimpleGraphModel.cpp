@@ -58,7 +58,7 @@ NodeId SimpleGraphModel::addNode(QString const nodeType)
     // Create new node.
     _nodeIds.insert(newId);
 
-    Q_EMIT nodeCreated(newId);
+    notifyNodeCreated(newId);
 
     return newId;
 }
@@ -72,7 +72,7 @@ void SimpleGraphModel::addConnection(ConnectionId const connectionId)
 {
     _connectivity.insert(connectionId);
 
-    Q_EMIT connectionCreated(connectionId);
+    notifyConnectionCreated(connectionId);
 }
 
 bool SimpleGraphModel::nodeExists(NodeId const nodeId) const
@@ -242,7 +242,7 @@ bool SimpleGraphModel::deleteConnection(ConnectionId const connectionId)
     }
 
     if (disconnected)
-        Q_EMIT connectionDeleted(connectionId);
+        notifyConnectionDeleted(connectionId);
 
     return disconnected;
 }
@@ -258,7 +258,7 @@ bool SimpleGraphModel::deleteNode(NodeId const nodeId)
     _nodeIds.erase(nodeId);
     _nodeGeometryData.erase(nodeId);
 
-    Q_EMIT nodeDeleted(nodeId);
+    notifyNodeDeleted(nodeId);
 
     return true;
 }
@@ -291,7 +291,7 @@ void SimpleGraphModel::loadNode(QJsonObject const &nodeJson)
     // Create new node.
     _nodeIds.insert(restoredNodeId);
 
-    Q_EMIT nodeCreated(restoredNodeId);
+    notifyNodeCreated(restoredNodeId);
 
     {
         QJsonObject posJson = nodeJson["position"].toObject();
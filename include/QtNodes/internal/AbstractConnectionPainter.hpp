@@ -4,6 +4,8 @@
 
 #include "Export.hpp"
 
+#include <vector>
+
 class QPainter;
 
 namespace QtNodes {
@@ -22,5 +24,28 @@ public:
     virtual void paint(QPainter *painter, ConnectionGraphicsObject const &cgo) const = 0;
 
     virtual QPainterPath getPainterStroke(ConnectionGraphicsObject const &cgo) const = 0;
+
+    /**
+     * With `BasicGraphicsScene::setConnectionBatching()` enabled, connections
+     * for which this returns true are drawn by `paintBatch()` while they are
+     * neither selected nor hovered. The default returns false, so every
+     * connection keeps being painted by `paint()`.
+     */
+    virtual bool batchable(ConnectionGraphicsObject const &cgo) const
+    {
+        Q_UNUSED(cgo);
+        return false;
+    }
+
+    /**
+     * Paints batchable connections together. The painter is in scene
+     * coordinates; the connection ends are in the coordinates of each item.
+     */
+    virtual void paintBatch(QPainter *painter,
+                            std::vector<ConnectionGraphicsObject const *> const &connections) const
+    {
+        Q_UNUSED(painter);
+        Q_UNUSED(connections);
+    }
 };
 } // namespace QtNodes
@@ -2,8 +2,10 @@
 
 #include "Export.hpp"
 
+#include <functional>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <QtCore/QJsonObject>
 #include <QtCore/QObject>
@@ -11,9 +13,43 @@
 
 #include "ConnectionIdHash.hpp"
 #include "Definitions.hpp"
+#include "NodeData.hpp"
 
 namespace QtNodes {
 
+/// Typed counterpart of the static port properties served by `portData()`.
+struct PortInfo
+{
+    NodeDataType dataType;
+
+    /// `NodeDataType::intern()` of the data type id, equal handles mean equal types.
+    unsigned int typeHandle = 0;
+
+    QString caption;
+
+    ConnectionPolicy connectionPolicy = ConnectionPolicy::One;
+
+    bool captionVisible = false;
+};
+
+/// Structural changes collected between `beginBatchUpdate()` and `endBatchUpdate()`.
+struct GraphChanges
+{
+    std::vector<NodeId> createdNodes;
+
+    std::vector<NodeId> deletedNodes;
+
+    std::vector<ConnectionId> createdConnections;
+
+    std::vector<ConnectionId> deletedConnections;
+
+    bool empty() const
+    {
+        return createdNodes.empty() && deletedNodes.empty() && createdConnections.empty()
+               && deletedConnections.empty();
+    }
+};
+
 /**
  * The central class in the Model-View approach. It delivers all kinds
  * of information from the backing user data structures that represent
@@ -27,6 +63,12 @@ namespace QtNodes {
 class NODE_EDITOR_PUBLIC AbstractGraphModel : public QObject
 {
     Q_OBJECT
+public:
+    /// Callbacks used by the `visit*` family of functions.
+    using ConnectionVisitor = std::function<void(ConnectionId const &)>;
+
+    using NodeVisitor = std::function<void(NodeId const)>;
+
 public:
     /// Generates a new unique NodeId.
     virtual NodeId newNodeId() = 0;
@@ -40,6 +82,13 @@ public:
    */
     virtual std::unordered_set<NodeId> allNodeIds() const = 0;
 
+    /// @brief Calls `visitor` for every node in the graph.
+    /**
+   * The default implementation iterates over the result of `allNodeIds()`.
+   * The visitor must not add or delete nodes.
+   */
+    virtual void visitNodes(NodeVisitor const &visitor) const;
+
     /**
    * A collection of all input and output connections for the given `nodeId`.
    */
@@ -55,6 +104,37 @@ public:
                                                          PortIndex index) const
         = 0;
 
+    /// @brief Returns the number of connections attached to the given port.
+    /**
+   * The default implementation counts the elements returned by
+   * `connections()`. Reimplement the function to answer the frequent "is
+   * this port connected?" question without building a temporary set.
+   */
+    virtual std::size_t connectionCount(NodeId nodeId, PortType portType, PortIndex index) const;
+
+    /// @brief Calls `visitor` for every connection attached to the given port.
+    /**
+   * An allocation-free alternative to `connections()` for the painting and
+   * data propagation code. The default implementation iterates over the
+   * result of `connections()`.
+   *
+   * The visitor must not modify the graph. Keep the captured state small
+   * (a couple of pointers or references) so that the `std::function`
+   * wrapper does not allocate either.
+   */
+    virtual void visitConnections(NodeId nodeId,
+                                  PortType portType,
+                                  PortIndex index,
+                                  ConnectionVisitor const &visitor) const;
+
+    /// @brief Calls `visitor` for every input and output connection of `nodeId`.
+    /**
+   * The default implementation iterates over the result of
+   * `allConnectionIds()`. The same restrictions as for `visitConnections()`
+   * apply.
+   */
+    virtual void visitAllConnections(NodeId nodeId, ConnectionVisitor const &visitor) const;
+
     /// Checks if two nodes with the given `connectionId` are connected.
     virtual bool connectionExists(ConnectionId const connectionId) const = 0;
 
@@ -143,6 +223,14 @@ public:
         return portData(nodeId, portType, index, role).value<T>();
     }
 
+    /// @brief Returns the port properties without QVariant round trips.
+    /**
+   * Used by the painters and geometry classes for every port on every
+   * repaint. The default implementation assembles the structure from
+   * `portData()`; reimplement the function to serve cached values.
+   */
+    virtual PortInfo portInfo(NodeId nodeId, PortType portType, PortIndex index) const;
+
     virtual bool setPortData(NodeId nodeId,
                              PortType portType,
                              PortIndex index,
@@ -225,6 +313,43 @@ public:
    */
     void portsInserted();
 
+public:
+    /// @brief Opens a group of structural changes.
+    /**
+   * Until the matching `endBatchUpdate()` the `notify*()` functions record
+   * the created and deleted nodes and connections instead of emitting the
+   * per-item signals. Batches can be nested, the outermost `endBatchUpdate()`
+   * emits a single `batchUpdateFinished()` and then replays the per-item
+   * signals, so receivers unaware of batches still see every change, only
+   * later. Receivers handling `batchUpdateFinished()` should ignore the
+   * per-item signals while `batchReplayActive()` is set.
+   *
+   * Other signals like `nodeUpdated` are still emitted immediately and may
+   * refer to nodes the views do not know about yet.
+   */
+    void beginBatchUpdate();
+
+    void endBatchUpdate();
+
+    bool batchUpdateActive() const { return _batchDepth > 0; }
+
+    /// Set while `endBatchUpdate()` replays the per-item signals of the batch.
+    bool batchReplayActive() const { return _batchReplayActive; }
+
+protected:
+    /**
+   * Models call these functions instead of emitting `nodeCreated`,
+   * `nodeDeleted`, `connectionCreated` and `connectionDeleted` directly in
+   * order to take part in batch updates.
+   */
+    void notifyNodeCreated(NodeId const nodeId);
+
+    void notifyNodeDeleted(NodeId const nodeId);
+
+    void notifyConnectionCreated(ConnectionId const connectionId);
+
+    void notifyConnectionDeleted(ConnectionId const connectionId);
+
 Q_SIGNALS:
     void connectionCreated(ConnectionId const connectionId);
 
@@ -242,8 +367,42 @@ Q_SIGNALS:
 
     void modelReset();
 
+    /**
+   * Emitted by the outermost `endBatchUpdate()`. Only the items that still
+   * exist are reported as created. An item deleted and re-created within the
+   * batch is listed in both the deleted and the created sets; receivers
+   * should process the deletions first.
+   */
+    void batchUpdateFinished(GraphChanges const &changes);
+
 private:
     std::vector<ConnectionId> _shiftedByDynamicPortsConnections;
+
+    unsigned int _batchDepth = 0;
+
+    bool _batchReplayActive = false;
+
+    GraphChanges _batchChanges;
+};
+
+/// Calls `beginBatchUpdate()` on construction and `endBatchUpdate()` on destruction.
+class GraphBatchUpdate
+{
+public:
+    explicit GraphBatchUpdate(AbstractGraphModel &model)
+        : _model(model)
+    {
+        _model.beginBatchUpdate();
+    }
+
+    ~GraphBatchUpdate() { _model.endBatchUpdate(); }
+
+    GraphBatchUpdate(GraphBatchUpdate const &) = delete;
+
+    GraphBatchUpdate &operator=(GraphBatchUpdate const &) = delete;
+
+private:
+    AbstractGraphModel &_model;
 };
 
 } // namespace QtNodes
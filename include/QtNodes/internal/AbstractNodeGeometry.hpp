@@ -36,6 +36,20 @@ public:
    */
     virtual void recomputeSize(NodeId const nodeId) const = 0;
 
+    /**
+   * Drops whatever the implementation cached for the node, e.g. after the
+   * node was deleted or its ports changed. The default does nothing.
+   *
+   * The default geometries do not compare their cache against the model. A
+   * model changing the caption, ports, size or embedded widget of a node
+   * emits `AbstractGraphModel::nodeUpdated()`, which makes the scene call
+   * `recomputeSize()`.
+   */
+    virtual void invalidate(NodeId const nodeId) const { Q_UNUSED(nodeId); }
+
+    /// Drops the cached data of all the nodes, e.g. after a model reset.
+    virtual void invalidateAll() const {}
+
     /// Port position in node's coordinate system.
     virtual QPointF portPosition(NodeId const nodeId,
                                  PortType const portType,
@@ -72,6 +86,21 @@ public:
 
     virtual QRect resizeHandleRect(NodeId const nodeId) const = 0;
 
+protected:
+    /**
+   * Lets geometries placing the ports on a regular grid compute the port of
+   * `portType` closest to `nodePoint` directly, along with its `position`
+   * from the same lookup. `checkPortHit()` then tests only that port, or
+   * reports no hit when `closest` is `InvalidPortIndex`.
+   *
+   * The default returns `false`, which makes `checkPortHit()` test every port.
+   */
+    virtual bool closestPort(NodeId const nodeId,
+                             PortType const portType,
+                             QPointF const nodePoint,
+                             PortIndex &closest,
+                             QPointF &position) const;
+
 protected:
     AbstractGraphModel &_graphModel;
 };
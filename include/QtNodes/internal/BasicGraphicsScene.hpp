@@ -1,19 +1,24 @@
 #pragma once
 
 #include <QtCore/QUuid>
+#include <QtCore/QVariant>
+#include <QtGui/QTransform>
 #include <QtWidgets/QGraphicsScene>
 #include <QtWidgets/QMenu>
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "AbstractGraphModel.hpp"
 #include "AbstractNodeGeometry.hpp"
 #include "ConnectionIdHash.hpp"
 #include "Definitions.hpp"
 #include "Export.hpp"
+#include "NodeSpatialIndex.hpp"
 
 #include "QUuidStdHash.hpp"
 
@@ -25,7 +30,9 @@ class AbstractConnectionPainter;
 class AbstractGraphModel;
 class AbstractNodePainter;
 class ConnectionGraphicsObject;
+class ConnectionLayerItem;
 class NodeGraphicsObject;
+class NodeStatePool;
 class NodeStyle;
 
 /// An instance of QGraphicsScene, holds connections and nodes.
@@ -58,6 +65,22 @@ public:
 
     QUndoStack &undoStack();
 
+    /// Bytes the undo history may retain; 0, the default, means unlimited.
+    std::size_t undoMemoryBudget() const { return _undoMemoryBudget; }
+
+    /**
+   * When the commands derived from `SceneUndoCommand` exceed the budget, the
+   * oldest ones are discarded and can no longer be undone. The most recent
+   * command is always kept.
+   */
+    void setUndoMemoryBudget(std::size_t bytes);
+
+    /// Approximate memory retained by the `SceneUndoCommand`s of the undo stack; constant time.
+    std::size_t undoMemoryUsage() const;
+
+    /// Shares equal node states between the commands of `undoStack()`.
+    NodeStatePool &nodeStatePool();
+
 public:
     /// Creates a "draft" instance of ConnectionGraphicsObject.
     /**
@@ -81,6 +104,28 @@ public:
     /// Deletes all the nodes. Connections are removed automatically.
     void clearScene();
 
+public:
+    /// Starts moving the selected nodes; the selection is captured once.
+    void beginNodeDrag();
+
+    /// Moves the nodes of the current drag without touching the undo stack.
+    void dragNodes(QPointF const &diff);
+
+    /// Pushes one `MoveNodeCommand` covering the whole drag.
+    void endNodeDrag();
+
+    bool nodeDragActive() const { return _nodeDragActive; }
+
+public:
+    /**
+   * Marks the connections of a moved node for `updateConnections()`, which
+   * runs once per event loop pass however many nodes moved.
+   */
+    void scheduleConnectionUpdate(NodeId const nodeId);
+
+    /// Makes every connection attached to the nodes moved since the last call follow them.
+    void updateConnections();
+
 public:
     /// @returns NodeGraphicsObject associated with the given nodeId.
     /**
@@ -98,6 +143,72 @@ public:
 
     void setOrientation(Qt::Orientation const orientation);
 
+    /**
+   * Node lookups, e.g. `locateNodeAt()`, go through a grid of the node
+   * rectangles instead of the scene items. Independent of
+   * `QGraphicsScene::itemIndexMethod()`, which stays `NoIndex`.
+   */
+    bool nodeIndexEnabled() const { return _nodeIndexEnabled; }
+
+    void setNodeIndexEnabled(bool enabled);
+
+    NodeSpatialIndex const &nodeIndex() const { return _nodeIndex; }
+
+    NodeSpatialIndex &nodeIndex() { return _nodeIndex; }
+
+    /// Refreshes the indexed rectangle after the node moved or was resized.
+    void updateNodeIndex(NodeId const nodeId);
+
+    /**
+   * Style of the node parsed from `NodeRole::Style`. The parsed style is kept
+   * until the model emits `nodeUpdated()` for the node or
+   * `StyleCollection::setNodeStyle()` is called, which also invalidates the
+   * node geometry. Nodes with equal style data share one instance.
+   */
+    NodeStyle const &nodeStyle(NodeId const nodeId);
+
+public:
+    /**
+   * When enabled, the connections accepted by
+   * `AbstractConnectionPainter::batchable()` are painted together by one
+   * `ConnectionLayerItem` while they are neither selected nor hovered. Their
+   * items stay in the scene for selection and hover. Disabled by default.
+   */
+    void setConnectionBatching(bool enabled);
+
+    bool connectionBatching() const { return _connectionBatching; }
+
+    /// @returns `nullptr` unless connection batching is enabled.
+    ConnectionLayerItem *connectionLayer() const { return _connectionLayer.get(); }
+
+public:
+    /**
+   * View scales below which the painters switch to `LevelOfDetail::Reduced`
+   * and `LevelOfDetail::Minimal`. Defaults are 0.6 and 0.4.
+   */
+    void setLevelOfDetailThresholds(double reducedScale, double minimalScale);
+
+    double reducedDetailScale() const { return _reducedDetailScale; }
+
+    double minimalDetailScale() const { return _minimalDetailScale; }
+
+    /// Level for painting with `transform`, e.g. `QPainter::worldTransform()`.
+    LevelOfDetail levelOfDetail(QTransform const &transform) const;
+
+    LevelOfDetail levelOfDetail(double scale) const;
+
+    /**
+   * Called by the views when they are zoomed, attached or detached. Node
+   * shadows, which are costly graphics effects, are only enabled at
+   * `LevelOfDetail::Full`. With several views the largest scale among
+   * `views()` decides, so zooming out one view does not remove the shadows
+   * from another one still showing full detail.
+   */
+    void updateViewScale();
+
+    /// Level of the largest view scale seen by `updateViewScale()`.
+    LevelOfDetail viewLevelOfDetail() const { return _viewLevelOfDetail; }
+
 public:
     /// Can @return an instance of the scene context menu in subclass.
     /**
@@ -139,6 +250,12 @@ private:
     /// Redraws adjacent nodes for given `connectionId`
     void updateAttachedNodes(ConnectionId const connectionId, PortType const portType);
 
+    /// Discards the oldest commands while the undo history exceeds the budget.
+    void trimUndoStack();
+
+    /// Switches the node shadows for the level of detail of `scale`.
+    void setViewScale(double scale);
+
 public Q_SLOTS:
     /// Slot called when the `connectionId` is erased form the AbstractGraphModel.
     void onConnectionDeleted(ConnectionId const connectionId);
@@ -150,6 +267,9 @@ public Q_SLOTS:
 
     void onNodeCreated(NodeId const nodeId);
 
+    /// Creates and removes the graphics objects of a whole batch in one pass.
+    void onBatchUpdateFinished(GraphChanges const &changes);
+
     void onNodePositionUpdated(NodeId const nodeId);
 
     void onNodeUpdated(NodeId const nodeId);
@@ -161,6 +281,11 @@ public Q_SLOTS:
 private:
     AbstractGraphModel &_graphModel;
 
+    /// Declared before the connections, which unregister from it when destroyed.
+    std::unique_ptr<ConnectionLayerItem> _connectionLayer;
+
+    bool _connectionBatching;
+
     using UniqueNodeGraphicsObject = std::unique_ptr<NodeGraphicsObject>;
 
     using UniqueConnectionGraphicsObject = std::unique_ptr<ConnectionGraphicsObject>;
@@ -179,8 +304,60 @@ private:
 
     bool _nodeDrag;
 
+    bool _nodeDragActive;
+
+    std::unordered_set<NodeId> _draggedNodes;
+
+    /// Total movement of the current drag.
+    QPointF _dragOffset;
+
+    std::unordered_set<NodeId> _movedNodes;
+
+    std::unordered_set<ConnectionId> _dirtyConnections;
+
+    bool _connectionUpdatePending;
+
+    NodeSpatialIndex _nodeIndex;
+
+    bool _nodeIndexEnabled;
+
+    /// `StyleCollection::nodeStyleGeneration()` the geometry was last laid out with.
+    unsigned int _geometryStyleGeneration;
+
+    struct CachedNodeStyle
+    {
+        std::shared_ptr<NodeStyle const> style;
+
+        /// `StyleCollection::nodeStyleGeneration()` at parsing time.
+        unsigned int generation;
+    };
+
+    std::unordered_map<NodeId, CachedNodeStyle> _nodeStyles;
+
+    /// Style data parsed last, reused when the next node returns the same data.
+    QVariant _lastStyleData;
+
+    std::shared_ptr<NodeStyle const> _lastStyle;
+
+    double _reducedDetailScale;
+
+    double _minimalDetailScale;
+
+    double _viewScale;
+
+    LevelOfDetail _viewLevelOfDetail;
+
     QUndoStack *_undoStack;
 
+    std::size_t _undoMemoryBudget;
+
+    /// Running total of the `SceneUndoCommand`s, kept by the commands themselves.
+    std::size_t _undoMemoryUsage;
+
+    std::unique_ptr<NodeStatePool> _nodeStatePool;
+
+    bool _trimmingUndoStack;
+
     Qt::Orientation _orientation;
 };
 
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "Definitions.hpp"
+#include "Export.hpp"
+#include "QStringStdHash.hpp"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QPointF>
+#include <QtCore/QString>
+
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace QtNodes {
+
+/**
+ * Binary counterpart of the JSON `.flow` scene format.
+ *
+ * The layout is flat and little-endian, so a reader can work directly on a
+ * memory-mapped file:
+ *
+ * ```
+ * Header          32 bytes   magic "QNSB", version, counts, blob area range
+ * NodeRecord      48 bytes   id, position, model name and internal data ranges
+ * ...
+ * ConnRecord      16 bytes   out node, out port, in node, in port
+ * ...
+ * Blob area                  UTF-8 model names (stored once), compact JSON
+ *                            of the node internal data without "model-name"
+ * ```
+ *
+ * Only the parts of the scene written by `DataFlowGraphModel::save()` are
+ * stored.
+ */
+namespace BinarySceneFormat {
+
+constexpr char Magic[4] = {'Q', 'N', 'S', 'B'};
+
+constexpr quint16 Version = 1;
+
+constexpr std::size_t HeaderSize = 32;
+
+constexpr std::size_t NodeRecordSize = 48;
+
+constexpr std::size_t ConnectionRecordSize = 16;
+
+/// @returns true if `data` starts with the binary scene signature.
+NODE_EDITOR_PUBLIC bool isBinaryScene(char const *data, std::size_t size);
+
+NODE_EDITOR_PUBLIC bool isBinaryScene(QByteArray const &data);
+
+/// Converts a scene in the JSON format of `DataFlowGraphModel::save()`.
+NODE_EDITOR_PUBLIC QByteArray fromSceneJson(QJsonObject const &sceneJson);
+
+/// Converts a binary scene back to JSON. Returns an empty object on malformed data.
+NODE_EDITOR_PUBLIC QJsonObject toSceneJson(QByteArray const &data, QString *errorString = nullptr);
+
+} // namespace BinarySceneFormat
+
+/// Accumulates nodes and connections and produces a binary scene.
+class NODE_EDITOR_PUBLIC BinarySceneWriter
+{
+public:
+    /// `internalData` is the output of `NodeDelegateModel::save()`.
+    void addNode(NodeId const nodeId, QPointF const &position, QJsonObject internalData);
+
+    void addConnection(ConnectionId const &connectionId);
+
+    QByteArray data() const;
+
+private:
+    struct Range
+    {
+        quint64 offset;
+        quint32 length;
+    };
+
+    Range appendBlob(QByteArray const &bytes);
+
+private:
+    QByteArray _nodeRecords;
+
+    QByteArray _connectionRecords;
+
+    QByteArray _blobs;
+
+    std::unordered_map<QString, Range> _modelNames;
+};
+
+/**
+ * Validating, non-owning view of a binary scene. The data must outlive the
+ * reader. Records are decoded on access.
+ */
+class NODE_EDITOR_PUBLIC BinarySceneReader
+{
+public:
+    BinarySceneReader(char const *data, std::size_t size);
+
+    explicit BinarySceneReader(QByteArray const &data);
+
+public:
+    bool isValid() const { return _errorString.isEmpty(); }
+
+    QString errorString() const { return _errorString; }
+
+    std::size_t nodeCount() const { return _nodeCount; }
+
+    std::size_t connectionCount() const { return _connectionCount; }
+
+    NodeId nodeId(std::size_t const index) const;
+
+    QPointF nodePosition(std::size_t const index) const;
+
+    QString nodeModelName(std::size_t const index) const;
+
+    /**
+     * Same object as `NodeDelegateModel::save()` produced, including "model-name".
+     * The data is parsed on access; if it is not a valid JSON object only
+     * "model-name" is returned and the parse error is stored in `errorString`.
+     */
+    QJsonObject nodeInternalData(std::size_t const index, QString *errorString = nullptr) const;
+
+    /// The node in the format of `DataFlowGraphModel::saveNode()`.
+    QJsonObject nodeJson(std::size_t const index, QString *errorString = nullptr) const;
+
+    ConnectionId connection(std::size_t const index) const;
+
+private:
+    char const *nodeRecord(std::size_t const index) const;
+
+    /// @returns the blob range or {nullptr, 0} if the range is out of bounds.
+    std::pair<char const *, std::size_t> blob(quint64 offset, quint32 length) const;
+
+private:
+    char const *_data;
+
+    std::size_t _nodeCount;
+
+    std::size_t _connectionCount;
+
+    char const *_blobs;
+
+    std::size_t _blobSize;
+
+    QString _errorString;
+};
+
+} // namespace QtNodes
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "AbstractNodeGeometry.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace QtNodes {
+
+class AbstractGraphModel;
+
+/**
+ * Keeps the measured and laid out geometry of every node, so the lookups
+ * used while painting and hit testing are plain reads.
+ *
+ * The record of a node is built by `recomputeSize()`, or on the first lookup
+ * of a node it was not built for, and kept until `invalidate()`. It is not
+ * compared against the model on lookups.
+ */
+class NODE_EDITOR_PUBLIC CachedNodeGeometry : public AbstractNodeGeometry
+{
+public:
+    CachedNodeGeometry(AbstractGraphModel &graphModel);
+
+public:
+    QSize size(NodeId const nodeId) const override;
+
+    /// Measures the node, passes the size to the model and lays it out.
+    void recomputeSize(NodeId const nodeId) const override;
+
+    QPointF portPosition(NodeId const nodeId,
+                         PortType const portType,
+                         PortIndex const index) const override;
+
+    QPointF portTextPosition(NodeId const nodeId,
+                             PortType const portType,
+                             PortIndex const PortIndex) const override;
+
+    QPointF captionPosition(NodeId const nodeId) const override;
+
+    QRectF captionRect(NodeId const nodeId) const override;
+
+    QPointF widgetPosition(NodeId const nodeId) const override;
+
+    void invalidate(NodeId const nodeId) const override;
+
+    void invalidateAll() const override;
+
+protected:
+    /// Projects `nodePoint` on the row of ports; constant time.
+    bool closestPort(NodeId const nodeId,
+                     PortType const portType,
+                     QPointF const nodePoint,
+                     PortIndex &closest,
+                     QPointF &position) const override;
+
+protected:
+    /// Geometry of one port in node's coordinate system.
+    struct PortGeometry
+    {
+        QPointF position;
+
+        QPointF textPosition;
+
+        QRectF textRect;
+    };
+
+    /**
+   * Everything the lookups return for one node. The text is measured by
+   * `measure()`, the positions depending on the node size are set by
+   * `layout()`.
+   */
+    struct NodeGeometry
+    {
+        QSize size;
+
+        QRectF captionRect;
+
+        QPointF captionPosition;
+
+        QPointF widgetPosition;
+
+        /// Widest port caption, indexed by `PortType`.
+        unsigned int portsTextAdvance[2] = {0, 0};
+
+        /// Room reserved for the port captions, indexed by `PortType`.
+        unsigned int portCaptionsHeight[2] = {0, 0};
+
+        /// Indexed by `PortType`.
+        std::vector<PortGeometry> ports[2];
+    };
+
+    /// Sets the caption rect, the port text rects and the text advances.
+    virtual void measure(NodeId const nodeId, NodeGeometry &geometry) const = 0;
+
+    /// @returns the size the measured node needs.
+    virtual QSize measuredSize(NodeId const nodeId, NodeGeometry const &geometry) const = 0;
+
+    /// Sets the positions for `geometry.size`.
+    virtual void layout(NodeId const nodeId, NodeGeometry &geometry) const = 0;
+
+private:
+    NodeGeometry const &nodeGeometry(NodeId const nodeId) const;
+
+    /// @returns `nullptr` for a port the node does not have.
+    PortGeometry const *portGeometry(NodeId const nodeId,
+                                     PortType const portType,
+                                     PortIndex const portIndex) const;
+
+private:
+    mutable std::unordered_map<NodeId, NodeGeometry> _nodeGeometries;
+};
+
+} // namespace QtNodes
@@ -3,6 +3,7 @@
 #include <utility>
 
 #include <QtCore/QUuid>
+#include <QtGui/QPainterPath>
 #include <QtWidgets/QGraphicsObject>
 
 #include "ConnectionState.hpp"
@@ -28,7 +29,7 @@ public:
 public:
     ConnectionGraphicsObject(BasicGraphicsScene &scene, ConnectionId const connectionId);
 
-    ~ConnectionGraphicsObject() = default;
+    ~ConnectionGraphicsObject();
 
 public:
     AbstractGraphModel &graphModel() const;
@@ -49,16 +50,37 @@ public:
 
     std::pair<QPointF, QPointF> pointsC1C2() const;
 
+    /// Cubic curve between the ends; kept until an end point changes.
+    QPainterPath const &cubicPath() const;
+
     void setEndPoint(PortType portType, QPointF const &point);
 
     /// Updates the position of both ends
     void move();
 
+    /**
+   * Follows the attached nodes after they moved. When both nodes moved by
+   * the same offset the connection is translated without recomputing its
+   * ends; otherwise this is `move()`.
+   */
+    void followNodes();
+
+    /**
+   * Hands the painting over to the scene's `ConnectionLayerItem` or takes it
+   * back, depending on the batching setting, the painter, the selection and
+   * the hover state.
+   */
+    void updateBatching();
+
+    bool batched() const { return _batched; }
+
     ConnectionState const &connectionState() const;
 
     ConnectionState &connectionState();
 
 protected:
+    QVariant itemChange(GraphicsItemChange change, QVariant const &value) override;
+
     void paint(QPainter *painter,
                QStyleOptionGraphicsItem const *option,
                QWidget *widget = 0) override;
@@ -76,6 +98,12 @@ protected:
 private:
     void initializePosition();
 
+    /// Rebuilds the control points, curve and curve bounds after an end moved.
+    void updateCurve() const;
+
+    /// Repaints the area of a batched connection in the connection layer.
+    void updateBatchedArea() const;
+
     void addGraphicsEffect();
 
     std::pair<QPointF, QPointF> pointsC1C2Horizontal() const;
@@ -91,6 +119,30 @@ private:
 
     mutable QPointF _out;
     mutable QPointF _in;
+
+    /// Node positions the ends were last computed for by `move()`.
+    QPointF _outNodePos;
+    QPointF _inNodePos;
+
+    bool _nodePosValid;
+
+    /// Cleared by `setEndPoint()`; the members below are rebuilt on next use.
+    mutable bool _curveValid;
+
+    mutable std::pair<QPointF, QPointF> _c1c2;
+
+    mutable QPainterPath _cubic;
+
+    /// Bounds of the ends and control points.
+    mutable QRectF _curveRect;
+
+    mutable bool _shapeValid;
+
+    /// Stroke built by `AbstractConnectionPainter::getPainterStroke()`.
+    mutable QPainterPath _shape;
+
+    /// Painted by the connection layer; the item itself has no contents.
+    bool _batched;
 };
 
 } // namespace QtNodes
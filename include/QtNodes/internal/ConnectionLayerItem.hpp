@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Export.hpp"
+
+#include <QtGui/QPainterPath>
+#include <QtWidgets/QGraphicsItem>
+
+#include <unordered_set>
+#include <vector>
+
+namespace QtNodes {
+
+class BasicGraphicsScene;
+class ConnectionGraphicsObject;
+
+/**
+ * Paints the batched connections of a scene in one pass.
+ *
+ * A connection is batched while the connection painter reports it as
+ * `AbstractConnectionPainter::batchable()` and it is neither selected nor
+ * hovered. Its own item then has no contents and only serves selection and
+ * hover; the layer hands all the visible batched connections to
+ * `AbstractConnectionPainter::paintBatch()`. The layer works in scene
+ * coordinates and never receives mouse events.
+ */
+class NODE_EDITOR_PUBLIC ConnectionLayerItem : public QGraphicsItem
+{
+public:
+    // Needed for qgraphicsitem_cast
+    enum { Type = UserType + 3 };
+
+    int type() const override { return Type; }
+
+public:
+    /// Adds itself to the scene below the nodes and the other connections.
+    explicit ConnectionLayerItem(BasicGraphicsScene &scene);
+
+public:
+    QRectF boundingRect() const override;
+
+    /// Empty, so that the layer is never hit.
+    QPainterPath shape() const override;
+
+    void insert(ConnectionGraphicsObject const *cgo);
+
+    void remove(ConnectionGraphicsObject const *cgo);
+
+    /**
+   * Repaints `sceneRect`, where a batched connection was or now is. The
+   * bounds grow right away; when the area reaches their edge, they are
+   * recomputed from the remaining connections once control returns to the
+   * event loop.
+   */
+    void updateConnectionArea(QRectF const &sceneRect);
+
+protected:
+    void paint(QPainter *painter,
+               QStyleOptionGraphicsItem const *option,
+               QWidget *widget = 0) override;
+
+private:
+    /// Shrinks the bounds to the connections left in the layer.
+    void updateBounds();
+
+private:
+    BasicGraphicsScene &_scene;
+
+    std::unordered_set<ConnectionGraphicsObject const *> _connections;
+
+    /// Covers the batched connections, and until `updateBounds()` the areas they left.
+    QRectF _bounds;
+
+    bool _boundsUpdatePending;
+
+    /// Reused between paints.
+    std::vector<ConnectionGraphicsObject const *> _visible;
+};
+
+} // namespace QtNodes
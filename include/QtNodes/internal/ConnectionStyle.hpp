@@ -5,6 +5,8 @@
 #include "Export.hpp"
 #include "Style.hpp"
 
+#include <vector>
+
 namespace QtNodes {
 
 class NODE_EDITOR_PUBLIC ConnectionStyle : public Style
@@ -28,6 +30,9 @@ public:
     QColor constructionColor() const;
     QColor normalColor() const;
     QColor normalColor(QString typeId) const;
+
+    /// Same as `normalColor(QString)`, memoized by `PortInfo::typeHandle`.
+    QColor normalColor(QString const &typeId, unsigned int typeHandle) const;
     QColor selectedColor() const;
     QColor selectedHaloColor() const;
     QColor hoveredColor() const;
@@ -53,5 +58,8 @@ private:
     float PointDiameter;
 
     bool UseDataDefinedColors;
+
+    /// Colors of the data types indexed by `PortInfo::typeHandle`.
+    mutable std::vector<QColor> _typeColors;
 };
 } // namespace QtNodes
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "AbstractGraphModel.hpp"
+#include "ConnectionIdHash.hpp"
 #include "ConnectionIdUtils.hpp"
 #include "NodeDelegateModelRegistry.hpp"
 #include "Serializable.hpp"
@@ -8,12 +9,20 @@
 
 #include "Export.hpp"
 
+#include <QByteArray>
 #include <QJsonObject>
+#include <QPointF>
 
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace QtNodes {
 
+class WorkStealingThreadPool;
+
 class NODE_EDITOR_PUBLIC DataFlowGraphModel : public AbstractGraphModel, public Serializable
 {
     Q_OBJECT
@@ -25,20 +34,56 @@ public:
         QPointF pos;
     };
 
+    /// Defines how data updates travel through the graph.
+    enum class PropagationMode {
+        /// Every `dataUpdated` is pushed downstream depth-first right away.
+        Immediate,
+        /**
+     * Updated outputs are collected and pushed once per event loop
+     * iteration. Affected nodes are evaluated in topological order and each
+     * of them receives all its new inputs in a single
+     * `NodeDelegateModel::setInDataBatch()` call.
+     */
+        Batched,
+        /**
+     * Same as `Batched`, but independent branches of the graph are evaluated
+     * concurrently on a work-stealing thread pool. Models not declaring
+     * `NodeDelegateModel::threadSafe()`, and the nodes they feed, are
+     * evaluated on the thread owning the graph. The graph must not be
+     * modified while it is evaluated.
+     */
+        Parallel
+    };
+
 public:
     DataFlowGraphModel(std::shared_ptr<NodeDelegateModelRegistry> registry);
 
+    ~DataFlowGraphModel() override;
+
     std::shared_ptr<NodeDelegateModelRegistry> dataModelRegistry() { return _registry; }
 
 public:
     std::unordered_set<NodeId> allNodeIds() const override;
 
+    void visitNodes(NodeVisitor const &visitor) const override;
+
     std::unordered_set<ConnectionId> allConnectionIds(NodeId const nodeId) const override;
 
     std::unordered_set<ConnectionId> connections(NodeId nodeId,
                                                  PortType portType,
                                                  PortIndex portIndex) const override;
 
+    std::size_t connectionCount(NodeId nodeId,
+                                PortType portType,
+                                PortIndex portIndex) const override;
+
+    void visitConnections(NodeId nodeId,
+                          PortType portType,
+                          PortIndex portIndex,
+                          ConnectionVisitor const &visitor) const override;
+
+    void visitAllConnections(NodeId nodeId, ConnectionVisitor const &visitor) const override;
+
     bool connectionExists(ConnectionId const connectionId) const override;
 
     NodeId addNode(QString const nodeType) override;
@@ -60,6 +105,17 @@ public:
                       PortIndex portIndex,
                       PortRole role) const override;
 
+    /// Served from a per-node table built on first use.
+    PortInfo portInfo(NodeId nodeId, PortType portType, PortIndex portIndex) const override;
+
+    /**
+   * Drops the cached port table of the node. Called automatically when the
+   * ports are inserted or deleted and when the node is updated, not when its
+   * data changes. Delegate models whose port captions or data types follow
+   * their data emit `NodeDelegateModel::portsUpdated()`.
+   */
+    void invalidatePortInfo(NodeId const nodeId);
+
     bool setPortData(NodeId nodeId,
                      PortType portType,
                      PortIndex portIndex,
@@ -70,14 +126,81 @@ public:
 
     bool deleteNode(NodeId const nodeId) override;
 
+    /// @throws std::out_of_range for an unknown node id.
     QJsonObject saveNode(NodeId const) const override;
 
     QJsonObject save() const override;
 
     void loadNode(QJsonObject const &nodeJson) override;
 
+    /**
+   * Restores the serialized node objects of `nodeElements` like `loadNode()`
+   * in the given order. The JSON parsing, the registry lookups and the
+   * position decoding run on the thread pool; the models are created and
+   * loaded on the calling thread once every element is decoded.
+   *
+   * @throws std::runtime_error for a malformed element and std::logic_error
+   * for an unknown model, before any node is created.
+   */
+    void loadNodesConcurrently(std::vector<QByteArray> const &nodeElements);
+
     void load(QJsonObject const &json) override;
 
+    /// Serializes the graph into the `BinarySceneFormat` layout.
+    QByteArray saveBinary() const;
+
+    /**
+   * Restores a graph written by `saveBinary()` or converted with
+   * `BinarySceneFormat::fromSceneJson()`. Throws `std::runtime_error` on
+   * malformed data and `std::logic_error` on unknown models, like `load()`.
+   */
+    void loadBinary(QByteArray const &data);
+
+    /**
+   * Restores a binary scene by memory-mapping the file read-only. The node
+   * models are created right away, but their internal data is only loaded
+   * when a node is first touched, i.e. its properties, ports or delegate model
+   * are queried. Until then saving copies the data straight from the file
+   * and data sent to the node is dropped; once the node is loaded its inputs
+   * are delivered from the event loop like after `addConnection()`. The file
+   * is unmapped once every node is loaded or deleted.
+   *
+   * Meant for headless processing of large scenes: a graphics scene queries
+   * every node when it creates the node items, so it should use
+   * `loadBinary()`.
+   *
+   * Throws like `loadBinary()`.
+   */
+    void loadMapped(QString const &fileName);
+
+    /// Number of nodes restored by `loadMapped()` whose data is not loaded yet.
+    std::size_t mappedNodeCount() const;
+
+    PropagationMode propagationMode() const { return _propagationMode; }
+
+    /**
+   * Switches the propagation mode. Updates still pending from the batched
+   * modes are flushed when switching back to `PropagationMode::Immediate`.
+   */
+    void setPropagationMode(PropagationMode mode);
+
+    /**
+   * Evaluates all the nodes affected by the pending output updates. Called
+   * automatically from the event loop in `PropagationMode::Batched`, may be
+   * called directly to get the results synchronously.
+   */
+    void flushPropagation();
+
+    /// Number of workers used by `PropagationMode::Parallel`.
+    unsigned int threadCount() const;
+
+    /**
+   * Sets the number of workers of the thread pool, `0` meaning one worker per
+   * hardware thread. The pool is recreated on next use, so this must not be
+   * called while the graph is evaluated.
+   */
+    void setThreadCount(unsigned int threadCount);
+
     /**
    * Fetches the NodeDelegateModel for the given `nodeId` and tries to cast the
    * stored pointer to the given type
@@ -85,11 +208,13 @@ public:
     template<typename NodeDelegateModelType>
     NodeDelegateModelType *delegateModel(NodeId const nodeId)
     {
-        auto it = _models.find(nodeId);
-        if (it == _models.end())
+        NodeEntry const *entry = nodeEntry(nodeId);
+        if (entry == nullptr)
             return nullptr;
 
-        auto model = dynamic_cast<NodeDelegateModelType *>(it->second.get());
+        materialize(*entry);
+
+        auto model = dynamic_cast<NodeDelegateModelType *>(entry->model.get());
 
         return model;
     }
@@ -97,13 +222,194 @@ public:
 Q_SIGNALS:
     void inPortDataWasSet(NodeId const, PortType const, PortIndex const);
 
+    /**
+   * The node announced new data on its output. Emitted on the thread owning
+   * the graph; nodes evaluated on the thread pool are reported through
+   * `inPortDataWasSet` only.
+   */
+    void outPortDataUpdated(NodeId const nodeId, PortIndex const portIndex);
+
+    /// Forwards `NodeDelegateModel::computingStarted()` of the node.
+    void nodeComputingStarted(NodeId const nodeId);
+
+    /// Forwards `NodeDelegateModel::computingFinished()` of the node.
+    void nodeComputingFinished(NodeId const nodeId);
+
 private:
+    /// Connections attached to the node, grouped by port type and `PortIndex`.
+    struct NodeConnections
+    {
+        std::vector<std::vector<ConnectionId>> in;
+        std::vector<std::vector<ConnectionId>> out;
+    };
+
+    /// Everything stored for one node, see `_nodes` and `_sparseNodes`.
+    struct NodeEntry
+    {
+        /// `nullptr` marks an unused slot.
+        std::unique_ptr<NodeDelegateModel> model;
+
+        NodeGeometryData geometry;
+
+        /**
+     * Adjacency index kept in sync with `_connectivity`. Makes port and node
+     * connection queries proportional to the node degree instead of the
+     * total number of connections in the graph.
+     */
+        NodeConnections connections;
+
+        /// Position of the node in `_nodeIds`.
+        std::size_t denseIndex = 0;
+
+        /// Port descriptors, valid while `portInfoValid` is set.
+        mutable std::vector<PortInfo> inPortInfo;
+        mutable std::vector<PortInfo> outPortInfo;
+        mutable bool portInfoValid = false;
+
+        /// Set while the internal data is still in `_mappedScene` at `mappedRecord`.
+        mutable bool mapped = false;
+        std::size_t mappedRecord = 0;
+    };
+
+    /// Binary scene file opened by `loadMapped()`.
+    struct MappedScene;
+
+    /// @returns the entry of an existing node or `nullptr`.
+    NodeEntry const *nodeEntry(NodeId const nodeId) const
+    {
+        if (nodeId < _nodes.size() && _nodes[nodeId].model)
+            return &_nodes[nodeId];
+
+        if (_sparseNodes.empty())
+            return nullptr;
+
+        auto it = _sparseNodes.find(nodeId);
+        return (it != _sparseNodes.end()) ? &it->second : nullptr;
+    }
+
+    NodeEntry *nodeEntry(NodeId const nodeId)
+    {
+        return const_cast<NodeEntry *>(static_cast<DataFlowGraphModel const *>(this)->nodeEntry(
+            nodeId));
+    }
+
+    /// A serialized node decoded off the owning thread.
+    struct DecodedNode
+    {
+        NodeId id = InvalidNodeId;
+
+        QPointF position;
+
+        QJsonObject internalData;
+
+        NodeDelegateModelRegistry::RegistryItemCreator const *creator = nullptr;
+    };
+
+    /// Thread-safe as long as the registry is not modified.
+    static void decodeNode(QByteArray const &nodeElement,
+                           NodeDelegateModelRegistry::RegisteredModelCreatorsMap const &creators,
+                           DecodedNode &decoded);
+
+    /// Creates the node of `loadNode()` from the already decoded parts.
+    void restoreNode(NodeId const restoredNodeId,
+                     QPointF const &pos,
+                     QJsonObject const &internalDataJson);
+
+    /// Creates and registers the model of a restored node without loading its data.
+    NodeDelegateModel *createRestoredNode(NodeId const restoredNodeId,
+                                          QPointF const &pos,
+                                          QString const &delegateModelName);
+
+    /// Wires and registers the model of a restored node.
+    NodeDelegateModel *insertRestoredNode(NodeId const restoredNodeId,
+                                          QPointF const &pos,
+                                          std::unique_ptr<NodeDelegateModel> model);
+
+    /// Loads the internal data of a node restored by `loadMapped()` on first use.
+    void materialize(NodeEntry const &entry) const
+    {
+        if (entry.mapped)
+            materializeMapped(entry);
+    }
+
+    void materializeMapped(NodeEntry const &entry) const;
+
+    /// Delivers the current upstream data to the inputs of a materialized node.
+    void restoreInputs(NodeId const nodeId);
+
+    void materializeAll();
+
+    /// Internal data of the node as `NodeDelegateModel::save()` returns it.
+    QJsonObject internalData(NodeEntry const &entry) const;
+
+    /**
+   * Stores the model under the given id. Throws `std::logic_error` when the
+   * id is invalid or already in use.
+   */
+    void insertNode(NodeId const nodeId, std::unique_ptr<NodeDelegateModel> model);
+
+    /**
+   * Forwards the signals of the node model to the graph. Shared by `addNode()`
+   * and the restoring functions, so restored nodes keep their port tables and
+   * geometry in sync with port changes too.
+   */
+    void connectNodeModel(NodeId const nodeId, NodeDelegateModel *model);
+
+    /// Releases the storage of a node, the entry must exist.
+    void eraseNode(NodeId const nodeId);
+
+    /// @returns the port table of the node, rebuilding it if needed.
+    std::vector<PortInfo> const &portInfoTable(NodeEntry const &entry, PortType portType) const;
+
     NodeId newNodeId() override { return _nextNodeId++; }
 
     void sendConnectionCreation(ConnectionId const connectionId);
 
     void sendConnectionDeletion(ConnectionId const connectionId);
 
+    /**
+   * @returns `true` if both nodes of the connection exist and have the
+   * connected ports. Connections failing the check are never stored.
+   */
+    bool connectionValid(ConnectionId const connectionId) const;
+
+    /// Registers the connection in the per-port adjacency index, which must be valid.
+    void indexConnection(ConnectionId const connectionId);
+
+    /// Removes the connection from the per-port adjacency index.
+    void unindexConnection(ConnectionId const connectionId);
+
+    /**
+   * @returns connections attached to the given port or `nullptr` when the
+   * port has no connections. The pointer is invalidated by any change of the
+   * graph connectivity.
+   */
+    std::vector<ConnectionId> const *portConnections(NodeId const nodeId,
+                                                     PortType const portType,
+                                                     PortIndex const portIndex) const;
+
+    /// Requests a `flushPropagation()` call from the event loop.
+    void schedulePropagation();
+
+    /**
+   * @returns nodes downstream of the pending output updates, sorted
+   * topologically. Nodes forming cycles or fed by them are appended at the
+   * end, `acyclicCount` receives the number of the properly sorted nodes.
+   */
+    std::vector<NodeId> propagationOrder(std::size_t *acyclicCount = nullptr) const;
+
+    /**
+   * Passes the pending updates of the upstream outputs to the node. Safe to
+   * call from several threads for different nodes.
+   */
+    void evaluateNode(NodeId const nodeId);
+
+    /// @returns the thread pool, creating it with `_threadCount` workers if needed.
+    WorkStealingThreadPool &threadPool();
+
+    /// Evaluates the nodes of `order` on the thread pool respecting dependencies.
+    void evaluateInParallel(std::vector<NodeId> const &order, std::size_t const acyclicCount);
+
 private Q_SLOTS:
     /**
    * Fuction is called in three cases:
@@ -125,11 +431,43 @@ private:
 
     NodeId _nextNodeId;
 
-    std::unordered_map<NodeId, std::unique_ptr<NodeDelegateModel>> _models;
+    /**
+   * Node storage indexed directly by `NodeId`, so a lookup is a bounds check
+   * and a test of the model pointer. Only ids below a limit proportional to
+   * the node count are stored here, empty slots at the end are released.
+   */
+    std::vector<NodeEntry> _nodes;
+
+    /// Nodes whose ids are too far beyond the dense range, e.g. read from a file.
+    std::unordered_map<NodeId, NodeEntry> _sparseNodes;
+
+    /// Ids of the existing nodes, stored contiguously for iteration.
+    std::vector<NodeId> _nodeIds;
 
     std::unordered_set<ConnectionId> _connectivity;
 
-    mutable std::unordered_map<NodeId, NodeGeometryData> _nodeGeometryData;
+    PropagationMode _propagationMode;
+
+    /// Output ports updated since the last propagation tick.
+    std::unordered_set<std::pair<NodeId, PortIndex>> _dirtyOutputs;
+
+    bool _propagationScheduled;
+
+    bool _propagating;
+
+    /// Guards `_dirtyOutputs` and `_updatedInputs` during parallel ticks.
+    std::mutex _propagationMutex;
+
+    /// Input ports set during the current tick, reported once it is over.
+    std::vector<std::pair<NodeId, PortIndex>> _updatedInputs;
+
+    /// Requested worker count, `0` for one per hardware thread.
+    unsigned int _threadCount;
+
+    std::unique_ptr<WorkStealingThreadPool> _threadPool;
+
+    /// Reset when the last mapped node is loaded, hence mutable.
+    mutable std::unique_ptr<MappedScene> _mappedScene;
 };
 
 } // namespace QtNodes
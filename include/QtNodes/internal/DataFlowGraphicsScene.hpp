@@ -28,6 +28,11 @@ public:
 public Q_SLOTS:
     bool save() const;
 
+    /**
+     * Asks for a `.flow` or `.flowb` file and loads it. Returns false if no
+     * file was opened. Throws `std::runtime_error` if the file is malformed,
+     * the scene is left empty then.
+     */
     bool load();
 
 Q_SIGNALS:
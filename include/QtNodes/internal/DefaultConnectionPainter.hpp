@@ -1,7 +1,14 @@
 #pragma once
 
+#include <QtGui/QIcon>
+#include <QtGui/QLinearGradient>
 #include <QtGui/QPainter>
 #include <QtGui/QPainterPath>
+#include <QtGui/QPixmap>
+
+#include <map>
+#include <tuple>
+#include <vector>
 
 #include "AbstractConnectionPainter.hpp"
 #include "Definitions.hpp"
@@ -16,15 +23,35 @@ class DefaultConnectionPainter : public AbstractConnectionPainter
 public:
     void paint(QPainter *painter, ConnectionGraphicsObject const &cgo) const override;
     QPainterPath getPainterStroke(ConnectionGraphicsObject const &cgo) const override;
+    /// All but connections being drawn and those joining different data types.
+    bool batchable(ConnectionGraphicsObject const &cgo) const override;
+    /// One path per color for the curves and one for the end points.
+    void paintBatch(QPainter *painter,
+                    std::vector<ConnectionGraphicsObject const *> const &connections)
+        const override;
     static QPolygonF createArrowPoly(const QPainterPath& p, double mRadius,double arrowSize,bool drawIn = true);
 private:
     QPainterPath cubicPath(ConnectionGraphicsObject const &connection) const;
+    /// Connection at `LevelOfDetail::Minimal`: a straight line between the ports.
+    void drawStraightLine(QPainter *painter, ConnectionGraphicsObject const &cgo) const;
     void drawSketchLine(QPainter *painter, ConnectionGraphicsObject const &cgo,QPainterPath const & cubic) const;
     void drawHoveredOrSelected(QPainter *painter, ConnectionGraphicsObject const &cgo,QPainterPath const & cubic) const;
     void drawNormalLine(QPainter *painter, ConnectionGraphicsObject const &cgo,QPainterPath const & cubic) const;
+    /// Marker drawn on connections between different data types, per device pixel ratio.
+    QPixmap const &conversionPixmap(qreal devicePixelRatio) const;
+    /// Out-to-in gradient of the given colors; only start and stop are left to set.
+    QLinearGradient const &conversionGradient(QColor const &out,
+                                              QColor const &in,
+                                              bool selected) const;
 #ifdef NODE_DEBUG_DRAWING
     void debugDrawing(QPainter *painter, ConnectionGraphicsObject const &cgo,QPainterPath const & cubic) const;
 #endif
+
+private:
+    // Shared by all the connections painted; nothing is loaded while painting.
+    mutable QIcon _conversionIcon;
+    mutable std::vector<std::pair<qreal, QPixmap>> _conversionPixmaps;
+    mutable std::map<std::tuple<QRgb, QRgb, bool>, QLinearGradient> _conversionGradients;
 };
 
 } // namespace QtNodes
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "AbstractNodeGeometry.hpp"
+#include "CachedNodeGeometry.hpp"
 
 #include <QtGui/QFontMetrics>
 
@@ -9,40 +9,20 @@ namespace QtNodes {
 class AbstractGraphModel;
 class BasicGraphicsScene;
 
-class NODE_EDITOR_PUBLIC DefaultHorizontalNodeGeometry : public AbstractNodeGeometry
+class NODE_EDITOR_PUBLIC DefaultHorizontalNodeGeometry : public CachedNodeGeometry
 {
 public:
     DefaultHorizontalNodeGeometry(AbstractGraphModel &graphModel);
 
 public:
-    QSize size(NodeId const nodeId) const override;
-
-    void recomputeSize(NodeId const nodeId) const override;
-
-    QPointF portPosition(NodeId const nodeId,
-                         PortType const portType,
-                         PortIndex const index) const override;
-
-    QPointF portTextPosition(NodeId const nodeId,
-                             PortType const portType,
-                             PortIndex const PortIndex) const override;
-    QPointF captionPosition(NodeId const nodeId) const override;
-
-    QRectF captionRect(NodeId const nodeId) const override;
-
-    QPointF widgetPosition(NodeId const nodeId) const override;
-
     QRect resizeHandleRect(NodeId const nodeId) const override;
 
-private:
-    QRectF portTextRect(NodeId const nodeId,
-                        PortType const portType,
-                        PortIndex const portIndex) const;
+protected:
+    void measure(NodeId const nodeId, NodeGeometry &geometry) const override;
 
-    /// Finds max number of ports and multiplies by (a port height + interval)
-    unsigned int maxVerticalPortsExtent(NodeId const nodeId) const;
+    QSize measuredSize(NodeId const nodeId, NodeGeometry const &geometry) const override;
 
-    unsigned int maxPortsTextAdvance(NodeId const nodeId, PortType const portType) const;
+    void layout(NodeId const nodeId, NodeGeometry &geometry) const override;
 
 private:
     // Some variables are mutable because we need to change drawing
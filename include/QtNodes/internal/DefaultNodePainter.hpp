@@ -21,6 +21,9 @@ public:
 
     void drawNodeRect(QPainter *painter, NodeGraphicsObject &ngo) const;
 
+    /// Node body at `LevelOfDetail::Minimal`: one filled rectangle.
+    void drawFlatNodeRect(QPainter *painter, NodeGraphicsObject &ngo) const;
+
     void drawConnectionPoints(QPainter *painter, NodeGraphicsObject &ngo) const;
 
     void drawFilledConnectionPoints(QPainter *painter, NodeGraphicsObject &ngo) const;
@@ -83,6 +83,16 @@ enum class PortType {
 };
 Q_ENUM_NS(PortType)
 
+/**
+ * Amount of detail drawn by the default painters, chosen from the view scale.
+ */
+enum class LevelOfDetail {
+    Full,    ///< Everything, including shadows, port dots and labels.
+    Reduced, ///< Node bodies and captions without shadows, ports and labels.
+    Minimal, ///< Flat node rectangles and straight connection lines.
+};
+Q_ENUM_NS(LevelOfDetail)
+
 using PortCount = unsigned int;
 
 /// ports are consecutively numbered starting from zero.
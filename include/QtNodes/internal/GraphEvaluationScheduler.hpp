@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Export.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace QtNodes {
+
+class WorkStealingThreadPool;
+
+/**
+ * Executes a directed acyclic graph of tasks.
+ *
+ * Every task keeps a counter of unfinished predecessors and is queued as soon
+ * as the counter drops to zero, so independent branches run in parallel on
+ * the thread pool. Tasks marked as `mainThreadOnly` are executed by the thread
+ * calling `run()`.
+ */
+class NODE_EDITOR_PUBLIC GraphEvaluationScheduler
+{
+public:
+    using Task = std::function<void()>;
+
+public:
+    explicit GraphEvaluationScheduler(WorkStealingThreadPool &pool);
+
+    GraphEvaluationScheduler(GraphEvaluationScheduler const &) = delete;
+
+    GraphEvaluationScheduler &operator=(GraphEvaluationScheduler const &) = delete;
+
+public:
+    /// @returns the index of the new task used by `addDependency()`.
+    std::size_t addTask(Task task, bool mainThreadOnly);
+
+    /// `after` is not started before `before` finishes.
+    void addDependency(std::size_t before, std::size_t after);
+
+    /**
+   * Runs all the tasks and blocks until they are finished. The first
+   * exception thrown by a task is rethrown here once the remaining tasks
+   * are done.
+   */
+    void run();
+
+private:
+    struct Node
+    {
+        Task task;
+        bool mainThreadOnly;
+        unsigned int predecessors;
+        std::vector<std::size_t> successors;
+    };
+
+    void schedule(std::size_t const index);
+
+    void execute(std::size_t const index);
+
+private:
+    WorkStealingThreadPool &_pool;
+
+    std::vector<Node> _nodes;
+
+    std::unique_ptr<std::atomic<unsigned int>[]> _unfinishedPredecessors;
+
+    /// Number of unfinished tasks, under `_mutex`.
+    std::size_t _remaining;
+
+    std::mutex _mutex;
+
+    std::condition_variable _changed;
+
+    /// Ready tasks waiting for the thread calling `run()`, under `_mutex`.
+    std::deque<std::size_t> _mainThreadQueue;
+
+    /// First exception thrown by a task, under `_mutex`.
+    std::exception_ptr _error;
+};
+
+} // namespace QtNodes
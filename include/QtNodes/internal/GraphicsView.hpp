@@ -25,6 +25,8 @@ public:
     GraphicsView(QWidget *parent = Q_NULLPTR);
     GraphicsView(BasicGraphicsScene *scene, QWidget *parent = Q_NULLPTR);
 
+    ~GraphicsView() override;
+
     GraphicsView(const GraphicsView &) = delete;
     GraphicsView operator=(const GraphicsView &) = delete;
 
@@ -17,6 +17,15 @@ struct NODE_EDITOR_PUBLIC NodeDataType
 {
     QString id;
     QString name;
+
+    /**
+   * Maps a type id to a small integer unique within the process, zero for
+   * the empty id. Registers the id on first use. Thread-safe.
+   *
+   * Types are not interned on construction, caches such as the port table
+   * of DataFlowGraphModel intern them once, see `PortInfo::typeHandle`.
+   */
+    static unsigned int intern(QString const &id);
 };
 
 /**
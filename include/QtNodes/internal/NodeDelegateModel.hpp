@@ -1,6 +1,10 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <QtWidgets/QWidget>
 
@@ -14,6 +18,24 @@ namespace QtNodes {
 
 class StyleCollection;
 
+struct AsyncComputeState;
+
+/// Lets an asynchronous computation know that its result is no longer needed.
+class CancellationToken
+{
+public:
+    CancellationToken()
+        : _cancelled(std::make_shared<std::atomic<bool>>(false))
+    {}
+
+    bool isCancelled() const { return *_cancelled; }
+
+    void cancel() const { *_cancelled = true; }
+
+private:
+    std::shared_ptr<std::atomic<bool>> _cancelled;
+};
+
 /**
  * The class wraps Node-specific data operations and propagates it to
  * the nesting DataFlowGraphModel which is a subclass of
@@ -32,9 +54,11 @@ public:
     unsigned int InPortCount=1;
     unsigned int OutPortCount=1;
     bool  PortEditable=false;
+
+public:
     NodeDelegateModel();
 
-    virtual ~NodeDelegateModel() = default;
+    virtual ~NodeDelegateModel();
 
     /// It is possible to hide caption in GUI
     virtual bool captionVisible() const { return CaptionVisible; }
@@ -62,6 +86,7 @@ public:
 public:
     virtual unsigned int nPorts(PortType portType) const;
 
+    /// Cached by DataFlowGraphModel, changes are announced with `portsUpdated()`.
     virtual NodeDataType dataType(PortType portType, PortIndex portIndex) const = 0;
 
 public:
@@ -74,6 +99,16 @@ public:
 public:
     virtual void setInData(std::shared_ptr<NodeData> nodeData, PortIndex const portIndex) = 0;
 
+    /// Receives all the inputs updated during one propagation tick.
+    /**
+   * Used by DataFlowGraphModel in the batched propagation mode. The entries
+   * are sorted by `PortIndex`. The default implementation forwards every
+   * entry to `setInData()`; reimplement the function to store all the inputs
+   * first and recompute the outputs only once.
+   */
+    virtual void setInDataBatch(
+        std::vector<std::pair<PortIndex, std::shared_ptr<NodeData>>> const &inputs);
+
     virtual std::shared_ptr<NodeData> outData(PortIndex const port) = 0;
 
     /**
@@ -92,6 +127,55 @@ public:
 
     virtual bool resizable() const { return Resizable; }
 
+    /**
+   * Declares that `setInData()` and `setInDataBatch()` may be called from a
+   * worker thread in `DataFlowGraphModel::PropagationMode::Parallel`. Such
+   * models must not touch their widgets there; use queued connections or
+   * `QMetaObject::invokeMethod()` to update the GUI. `outData()` of a
+   * thread-safe model may be called from a worker thread as well. A node fed
+   * by a model that is not thread-safe is evaluated on the owning thread.
+   */
+    virtual bool threadSafe() const { return false; }
+
+    /// `true` while an asynchronous computation is running.
+    bool isComputing() const;
+
+protected:
+    /// Output data of several ports.
+    using PortDataList = std::vector<std::pair<PortIndex, std::shared_ptr<NodeData>>>;
+
+    /// Computes the outputs of the node off the GUI thread.
+    using ComputeFunction = std::function<PortDataList(CancellationToken const &)>;
+
+    /**
+   * Runs `function` on the global QThreadPool and passes its result to
+   * `setComputedOutData()` on the thread owning the model.
+   *
+   * A computation which is still running gets cancelled through its token,
+   * and out of the calls made meanwhile only the last one is started after
+   * it. Results of outdated computations are dropped, so the nodes
+   * downstream only see the newest outputs. `computingStarted()` and
+   * `computingFinished()` enclose such a series of computations.
+   *
+   * The function runs on a worker thread: capture the inputs by value and
+   * never the model itself. Call `computeAsync()` from the thread owning the
+   * model, typically from `setInData()`.
+   */
+    void computeAsync(ComputeFunction function);
+
+    /// Cancels the running computation and drops the queued one.
+    void cancelCompute();
+
+    /**
+   * Receives the result of the newest asynchronous computation. The default
+   * implementation stores the outputs, see `computedOutData()`, and emits
+   * `dataUpdated()` for each of them.
+   */
+    virtual void setComputedOutData(PortDataList const &outputs);
+
+    /// Output stored by the default `setComputedOutData()`, to be returned from `outData()`.
+    std::shared_ptr<NodeData> computedOutData(PortIndex const port) const;
+
 public Q_SLOTS:
 
     virtual void inputConnectionCreated(ConnectionId const &) {}
@@ -138,8 +222,24 @@ Q_SIGNALS:
     /// Call this function when data and port moditications are finished.
     void portsInserted();
 
+    /**
+   * Call this function when the captions or data types of the ports changed,
+   * e.g. with the received data. DataFlowGraphModel caches them otherwise.
+   */
+    void portsUpdated();
+
+private:
+    AsyncComputeState &asyncState();
+
+    void startCompute(ComputeFunction function);
+
+    void finishCompute(PortDataList const &outputs, CancellationToken const &token);
+
 private:
     NodeStyle _nodeStyle;
+
+    /// Created by the first `computeAsync()` call, shared with the workers.
+    std::shared_ptr<AsyncComputeState> _asyncState;
 };
 
 } // namespace QtNodes
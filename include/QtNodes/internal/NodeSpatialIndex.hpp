@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Definitions.hpp"
+#include "Export.hpp"
+
+#include <QtCore/QPointF>
+#include <QtCore/QRectF>
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace QtNodes {
+
+/**
+ * Uniform grid over the scene rectangles of the nodes.
+ *
+ * Every node is registered in all the cells its rectangle overlaps, so a
+ * lookup only visits the cells covering the queried area instead of every
+ * item of the scene. Updating a node that stays within the same cells only
+ * replaces its rectangle. Nodes spanning very many cells are kept aside and
+ * checked by every query.
+ */
+class NODE_EDITOR_PUBLIC NodeSpatialIndex
+{
+public:
+    explicit NodeSpatialIndex(qreal cellSize = 256.0);
+
+public:
+    qreal cellSize() const { return _cellSize; }
+
+    /// Re-registers all the nodes in cells of the new size.
+    void setCellSize(qreal cellSize);
+
+    /// Inserts the node or updates its rectangle.
+    void update(NodeId const nodeId, QRectF const &sceneRect);
+
+    void remove(NodeId const nodeId);
+
+    void clear();
+
+    std::size_t size() const { return _entries.size(); }
+
+    /// Appends the nodes whose rectangles intersect `rect`, each once.
+    void query(QRectF const &rect, std::vector<NodeId> &result) const;
+
+    /// Appends the nodes whose rectangles contain `point`.
+    void query(QPointF const &point, std::vector<NodeId> &result) const;
+
+private:
+    struct CellRange
+    {
+        int left;
+        int top;
+        int right;
+        int bottom;
+    };
+
+    struct Entry
+    {
+        QRectF rect;
+
+        CellRange cells;
+
+        /// Query that last reported the node; avoids duplicates without a set.
+        mutable unsigned int stamp;
+    };
+
+    int cellCoordinate(qreal const value) const;
+
+    CellRange cellRange(QRectF const &rect) const;
+
+    void insertIntoCells(NodeId const nodeId, CellRange const &cells);
+
+    void removeFromCells(NodeId const nodeId, CellRange const &cells);
+
+    unsigned int nextStamp() const;
+
+private:
+    qreal _cellSize;
+
+    std::unordered_map<NodeId, Entry> _entries;
+
+    std::unordered_map<quint64, std::vector<NodeId>> _cells;
+
+    /// Nodes too large to be registered cell by cell.
+    std::vector<NodeId> _oversizedNodes;
+
+    mutable unsigned int _stamp;
+
+    /// Lets the unit tests move the query stamp close to its wraparound.
+    friend struct NodeSpatialIndexTestAccess;
+};
+
+} // namespace QtNodes
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "AbstractGraphModel.hpp"
+#include "ConnectionIdHash.hpp"
+#include "Definitions.hpp"
+#include "Export.hpp"
+
+#include <QtCore/QJsonObject>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include <unordered_map>
+#include <unordered_set>
+
+class QIODevice;
+
+namespace QtNodes {
+
+class DataFlowGraphModel;
+
+/**
+ * Incremental persistence of a DataFlowGraphModel for autosaving.
+ *
+ * The journal tracks which nodes were created, deleted, moved or changed
+ * their internal data and which connections were added or removed. `save()`
+ * appends only these changes to an append-only journal file, one compact JSON
+ * object per line, on top of a full binary snapshot written with
+ * `DataFlowGraphModel::saveBinary()`. The snapshot is rewritten and the
+ * journal truncated every `compactionThreshold()` deltas or after `compact()`.
+ *
+ * The snapshot and the first line of the journal carry a generation number
+ * incremented by every snapshot. A journal left behind by a crash between
+ * writing a snapshot and truncating the journal has an older generation and
+ * is not replayed.
+ *
+ * Changes of the internal data are detected through `nodeUpdated` only; data
+ * passing through the ports does not mark a node. Models changing their
+ * saved state otherwise, e.g. from an embedded widget, should be reported
+ * with `markNodeChanged()`.
+ */
+class NODE_EDITOR_PUBLIC SceneJournal : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SceneJournal(DataFlowGraphModel &graphModel, QObject *parent = nullptr);
+
+public:
+    bool hasChanges() const;
+
+    void markNodeChanged(NodeId const nodeId);
+
+    /// Number of deltas appended after which `save()` writes a new snapshot.
+    int compactionThreshold() const { return _compactionThreshold; }
+
+    void setCompactionThreshold(int threshold);
+
+    /// Makes the next `save()` write a full snapshot.
+    void compact() { _snapshotRequired = true; }
+
+    /**
+   * Persists the changes since the previous call, either as a delta appended
+   * to `journalFile` or as a new `snapshotFile` with an empty journal.
+   */
+    bool save(QString const &snapshotFile, QString const &journalFile);
+
+    /**
+   * Loads the snapshot into the empty model and replays the journal if its
+   * generation matches. A truncated last line, as left by a crash during
+   * `save()`, is ignored. Throws like `DataFlowGraphModel::loadBinary()`.
+   */
+    bool load(QString const &snapshotFile, QString const &journalFile);
+
+    /// Changes since the previous call as a delta object. Clears the tracked changes.
+    QJsonObject takeDelta();
+
+    /// Forgets the tracked changes, e.g. after saving the scene by other means.
+    void clear();
+
+    static void applyDelta(DataFlowGraphModel &graphModel, QJsonObject const &delta);
+
+    /**
+   * Applies every delta of the journal, positioned after its generation
+   * header. Returns the number of applied deltas.
+   */
+    static int replay(DataFlowGraphModel &graphModel, QIODevice &journal);
+
+private Q_SLOTS:
+    void onNodeCreated(NodeId const nodeId);
+
+    void onNodeDeleted(NodeId const nodeId);
+
+    void onConnectionCreated(ConnectionId const connectionId);
+
+    void onConnectionDeleted(ConnectionId const connectionId);
+
+    void onBatchUpdateFinished(GraphChanges const &changes);
+
+private:
+    enum NodeChange : unsigned int
+    {
+        Created = 0x1,
+        Moved = 0x2,
+        DataChanged = 0x4,
+    };
+
+    void mark(NodeId const nodeId, unsigned int const change);
+
+    bool writeSnapshot(QString const &snapshotFile, QString const &journalFile);
+
+private:
+    DataFlowGraphModel &_graphModel;
+
+    int _compactionThreshold;
+
+    bool _snapshotRequired;
+
+    int _deltaCount;
+
+    /// Generation of the last snapshot written or loaded.
+    quint64 _generation;
+
+    /// `NodeChange` flags of the nodes changed since the last save.
+    std::unordered_map<NodeId, unsigned int> _changedNodes;
+
+    std::unordered_set<NodeId> _deletedNodes;
+
+    std::unordered_set<ConnectionId> _createdConnections;
+
+    std::unordered_set<ConnectionId> _deletedConnections;
+};
+
+} // namespace QtNodes
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "Definitions.hpp"
+#include "Export.hpp"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QIODevice>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QString>
+#include <QtCore/QTimer>
+
+#include <vector>
+
+namespace QtNodes {
+
+class DataFlowGraphModel;
+
+/**
+ * Loads a `.flow` scene without reading the whole file into memory.
+ *
+ * The device is read in chunks and scanned for the elements of the top-level
+ * `nodes` and `connections` arrays. Every element is parsed on its own and
+ * handed to `DataFlowGraphModel::loadNode()` right away, so the peak memory
+ * is one chunk plus one element. Connections are restored after all the
+ * nodes in the file order, which gives the same graph as
+ * `DataFlowGraphModel::load()`.
+ *
+ * `load()` runs to completion. `start()` processes `stepSize()` elements per
+ * event loop iteration and reports the progress with signals.
+ *
+ * In the concurrent mode up to `stepSize()` node elements are collected and
+ * decoded together on the thread pool of the graph model, see
+ * `DataFlowGraphModel::loadNodesConcurrently()`.
+ */
+class NODE_EDITOR_PUBLIC StreamingSceneLoader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StreamingSceneLoader(DataFlowGraphModel &graphModel, QObject *parent = nullptr);
+
+    ~StreamingSceneLoader() override;
+
+public:
+    /// Number of bytes requested from the device at once.
+    qint64 chunkSize() const { return _chunkSize; }
+
+    void setChunkSize(qint64 chunkSize);
+
+    /// Number of array elements processed by one asynchronous step.
+    int stepSize() const { return _stepSize; }
+
+    void setStepSize(int stepSize);
+
+    /// Whether the node elements are decoded on the thread pool. Off by default.
+    bool concurrent() const { return _concurrent; }
+
+    void setConcurrent(bool concurrent);
+
+    /// Reads the whole `device`. Returns false and sets `errorString()` on failure.
+    bool load(QIODevice &device);
+
+    /**
+   * Starts reading `device` asynchronously. The device must stay open until
+   * `finished()` is emitted. A load already in progress is cancelled.
+   */
+    void start(QIODevice *device);
+
+    /// Stops the asynchronous load without emitting `finished()`. The items
+    /// loaded so far stay in the model.
+    void cancel();
+
+    bool isRunning() const { return _running; }
+
+    QString errorString() const { return _errorString; }
+
+Q_SIGNALS:
+    void progress(qint64 bytesRead, qint64 bytesTotal);
+
+    void finished(bool success);
+
+private Q_SLOTS:
+    void step();
+
+private:
+    enum class Section { None, Nodes, Connections };
+
+    void reset(QIODevice *device);
+
+    /// Processes up to `maxElements` elements. Returns false when the input is exhausted.
+    bool processElements(int maxElements);
+
+    /// Extracts the next complete element of a known array into `_element`.
+    bool nextElement(Section &section);
+
+    void processElement(Section const section);
+
+    /// Restores the node elements collected in the concurrent mode.
+    void flushNodeElements();
+
+    bool readChunk();
+
+    void restoreConnections();
+
+    void fail(QString const &message);
+
+private:
+    DataFlowGraphModel &_graphModel;
+
+    qint64 _chunkSize;
+
+    int _stepSize;
+
+    bool _concurrent;
+
+    QPointer<QIODevice> _device;
+
+    bool _running;
+
+    QTimer _stepTimer;
+
+    QString _errorString;
+
+    // Scanner state.
+
+    QByteArray _buffer;
+
+    int _position;
+
+    qint64 _bytesRead;
+
+    int _depth;
+
+    bool _inString;
+
+    bool _escaped;
+
+    QByteArray _key;
+
+    QByteArray _currentKey;
+
+    Section _section;
+
+    /// Start of the element being extracted in `_buffer`, or -1.
+    int _elementStart;
+
+    /// Parts of the current element taken from the previous chunks.
+    QByteArray _element;
+
+    /// Restored once all the nodes exist, like in `DataFlowGraphModel::load()`.
+    std::vector<ConnectionId> _connections;
+
+    /// Node elements waiting for `flushNodeElements()`.
+    std::vector<QByteArray> _nodeElements;
+};
+
+} // namespace QtNodes
@@ -17,6 +17,9 @@ public:
 
     static GraphicsViewStyle const &flowViewStyle();
 
+    /// Incremented by every `setNodeStyle()`; lets caches of parsed styles expire.
+    static unsigned int nodeStyleGeneration();
+
 public:
     static void setNodeStyle(NodeStyle);
 
@@ -39,5 +42,7 @@ private:
     ConnectionStyle _connectionStyle;
 
     GraphicsViewStyle _flowViewStyle;
+
+    unsigned int _nodeStyleGeneration = 0;
 };
 } // namespace QtNodes
@@ -3,16 +3,117 @@
 #include "Definitions.hpp"
 
 #include <QUndoCommand>
+#include <QtCore/QByteArray>
 #include <QtCore/QJsonObject>
 #include <QtCore/QPointF>
 
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace QtNodes {
 
 class BasicGraphicsScene;
 
-class NODE_EDITOR_PUBLIC CreateCommand : public QUndoCommand
+/**
+ * Compact undo data of a group of nodes and their connections.
+ *
+ * Instead of `QJsonObject` trees the nodes keep their id and position
+ * unpacked and the rest of `AbstractGraphModel::saveNode()` as compact,
+ * possibly compressed JSON. Equal node states, e.g. repeated pastes of the
+ * same clipboard, share one buffer between commands.
+ */
+struct NODE_EDITOR_PUBLIC SerializedItems
+{
+    struct NodeState
+    {
+        QByteArray data;
+
+        bool compressed;
+    };
+
+    struct Node
+    {
+        NodeId id;
+
+        QPointF position;
+
+        std::shared_ptr<NodeState const> state;
+    };
+
+    std::vector<Node> nodes;
+
+    std::vector<ConnectionId> connections;
+
+    bool empty() const { return nodes.empty() && connections.empty(); }
+
+    /// Approximate number of bytes held. Shared node states are counted in full.
+    std::size_t memoryUsage() const;
+};
+
+/**
+ * Interns the node states of `SerializedItems`. Each `BasicGraphicsScene`
+ * owns one, so states are only shared between the commands of one undo
+ * stack. The pool does not own the states, they are released with the last
+ * command holding them.
+ */
+class NODE_EDITOR_PUBLIC NodeStatePool
+{
+public:
+    /// Returns the state equal to `data` if some command still holds one, else a new state.
+    std::shared_ptr<SerializedItems::NodeState const> share(QByteArray data);
+
+    /// Number of entries, including the expired ones not swept yet.
+    std::size_t size() const { return _states.size(); }
+
+private:
+    std::unordered_multimap<std::size_t, std::weak_ptr<SerializedItems::NodeState const>> _states;
+
+    /// Expired entries are swept whenever the pool has doubled since the previous sweep.
+    std::size_t _sweepSize = 64;
+};
+
+/**
+ * Base of the commands pushed by the scene. Reports the memory retained for
+ * undo/redo so that `BasicGraphicsScene` can keep the undo history within
+ * `undoMemoryBudget()`.
+ */
+class NODE_EDITOR_PUBLIC SceneUndoCommand : public QUndoCommand
+{
+public:
+    ~SceneUndoCommand() override;
+
+    virtual std::size_t memoryUsage() const { return sizeof(SceneUndoCommand); }
+
+    /**
+   * Releases the undo data and marks the command obsolete. `QUndoStack`
+   * removes obsolete commands without executing them.
+   */
+    void discard();
+
+protected:
+    virtual void releaseUndoData() {}
+
+private:
+    friend class BasicGraphicsScene;
+
+    /**
+   * Adds the change of `memoryUsage()` since the last call to `total`,
+   * obsolete commands count as zero. The destructor takes the command's
+   * part back out of the total.
+   */
+    void accountMemory(std::size_t &total);
+
+private:
+    std::size_t *_memoryTotal = nullptr;
+
+    /// Part of `*_memoryTotal` contributed by this command.
+    std::size_t _accountedMemory = 0;
+};
+
+class NODE_EDITOR_PUBLIC CreateCommand : public SceneUndoCommand
 {
 public:
     CreateCommand(BasicGraphicsScene *scene, QString const name, QPointF const &mouseScenePos);
@@ -20,17 +121,22 @@ public:
     void undo() override;
     void redo() override;
 
+    std::size_t memoryUsage() const override;
+
+protected:
+    void releaseUndoData() override;
+
 private:
     BasicGraphicsScene *_scene;
     NodeId _nodeId;
-    QJsonObject _sceneJson;
+    SerializedItems _items;
 };
 
 /**
  * Selected scene objects are serialized and then removed from the scene.
  * The deleted elements could be restored in `undo`.
  */
-class NODE_EDITOR_PUBLIC DeleteCommand : public QUndoCommand
+class NODE_EDITOR_PUBLIC DeleteCommand : public SceneUndoCommand
 {
 public:
     DeleteCommand(BasicGraphicsScene *scene);
@@ -38,18 +144,23 @@ public:
     void undo() override;
     void redo() override;
 
+    std::size_t memoryUsage() const override;
+
+protected:
+    void releaseUndoData() override;
+
 private:
     BasicGraphicsScene *_scene;
-    QJsonObject _sceneJson;
+    SerializedItems _items;
 };
 
-class NODE_EDITOR_PUBLIC CopyCommand : public QUndoCommand
+class NODE_EDITOR_PUBLIC CopyCommand : public SceneUndoCommand
 {
 public:
     CopyCommand(BasicGraphicsScene *scene);
 };
 
-class NODE_EDITOR_PUBLIC PasteCommand : public QUndoCommand
+class NODE_EDITOR_PUBLIC PasteCommand : public SceneUndoCommand
 {
 public:
     PasteCommand(BasicGraphicsScene *scene, QPointF const &mouseScenePos);
@@ -57,17 +168,22 @@ public:
     void undo() override;
     void redo() override;
 
+    std::size_t memoryUsage() const override;
+
+protected:
+    void releaseUndoData() override;
+
 private:
     QJsonObject takeSceneJsonFromClipboard();
-    QJsonObject makeNewNodeIdsInScene(QJsonObject const &sceneJson);
+    void makeNewNodeIdsInScene(SerializedItems &items);
 
 private:
     BasicGraphicsScene *_scene;
     QPointF const &_mouseScenePos;
-    QJsonObject _newSceneJson;
+    SerializedItems _items;
 };
 
-class NODE_EDITOR_PUBLIC DisconnectCommand : public QUndoCommand
+class NODE_EDITOR_PUBLIC DisconnectCommand : public SceneUndoCommand
 {
 public:
     DisconnectCommand(BasicGraphicsScene *scene, ConnectionId const);
@@ -81,7 +197,7 @@ private:
     ConnectionId _connId;
 };
 
-class NODE_EDITOR_PUBLIC ConnectCommand : public QUndoCommand
+class NODE_EDITOR_PUBLIC ConnectCommand : public SceneUndoCommand
 {
 public:
     ConnectCommand(BasicGraphicsScene *scene, ConnectionId const);
@@ -95,11 +211,19 @@ private:
     ConnectionId _connId;
 };
 
-class NODE_EDITOR_PUBLIC MoveNodeCommand : public QUndoCommand
+class NODE_EDITOR_PUBLIC MoveNodeCommand : public SceneUndoCommand
 {
 public:
     MoveNodeCommand(BasicGraphicsScene *scene, QPointF const &diff);
 
+    /**
+   * Records a finished drag of `nodes` by `diff`. The nodes are already in
+   * place, so the `redo()` run by `QUndoStack::push()` does nothing.
+   */
+    MoveNodeCommand(BasicGraphicsScene *scene,
+                    std::unordered_set<NodeId> nodes,
+                    QPointF const &diff);
+
     void undo() override;
     void redo() override;
 
@@ -114,10 +238,13 @@ public:
    */
     bool mergeWith(QUndoCommand const *c) override;
 
+    std::size_t memoryUsage() const override;
+
 private:
     BasicGraphicsScene *_scene;
     std::unordered_set<NodeId> _selectedNodes;
     QPointF _diff;
+    bool _skipRedo;
 };
 
 } // namespace QtNodes
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Export.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace QtNodes {
+
+/**
+ * A fixed size thread pool where every worker owns a task queue.
+ *
+ * Tasks submitted from a worker thread go to the queue of that worker and
+ * are taken from its back, which keeps dependent work on a warm cache. Idle
+ * workers steal the oldest tasks from the front of the other queues.
+ */
+class NODE_EDITOR_PUBLIC WorkStealingThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+public:
+    /// `threadCount == 0` creates one worker per hardware thread.
+    explicit WorkStealingThreadPool(unsigned int threadCount = 0);
+
+    /// Finishes all the queued tasks and joins the workers.
+    ~WorkStealingThreadPool();
+
+    WorkStealingThreadPool(WorkStealingThreadPool const &) = delete;
+
+    WorkStealingThreadPool &operator=(WorkStealingThreadPool const &) = delete;
+
+public:
+    unsigned int threadCount() const { return static_cast<unsigned int>(_threads.size()); }
+
+    /// Queues the task. The function is thread-safe.
+    void submit(Task task);
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(unsigned int const index);
+
+    bool popLocal(unsigned int const index, Task &task);
+
+    bool steal(unsigned int const index, Task &task);
+
+private:
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    std::vector<std::thread> _threads;
+
+    std::mutex _sleepMutex;
+
+    std::condition_variable _wakeUp;
+
+    /// Number of queued tasks, incremented under `_sleepMutex`.
+    std::atomic<std::size_t> _pending;
+
+    std::atomic<unsigned int> _nextWorker;
+
+    bool _stopping;
+};
+
+} // namespace QtNodes
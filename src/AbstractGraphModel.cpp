@@ -2,8 +2,76 @@
 
 #include <QtNodes/ConnectionIdUtils>
 
+#include <algorithm>
+#include <unordered_set>
+
 namespace QtNodes {
 
+namespace {
+
+/// Drops repeated entries and the entries rejected by `keep`.
+template<typename Id, typename Predicate>
+void uniqueIds(std::vector<Id> &ids, Predicate keep)
+{
+    std::unordered_set<Id> seen;
+    seen.reserve(ids.size());
+
+    auto end = std::remove_if(ids.begin(), ids.end(), [&](Id const &id) {
+        return !seen.insert(id).second || !keep(id);
+    });
+
+    ids.erase(end, ids.end());
+}
+
+} // namespace
+
+PortInfo AbstractGraphModel::portInfo(NodeId nodeId, PortType portType, PortIndex index) const
+{
+    PortInfo info;
+
+    info.dataType = portData<NodeDataType>(nodeId, portType, index, PortRole::DataType);
+    info.typeHandle = NodeDataType::intern(info.dataType.id);
+    info.caption = portData<QString>(nodeId, portType, index, PortRole::Caption);
+    info.connectionPolicy = portData<ConnectionPolicy>(nodeId,
+                                                       portType,
+                                                       index,
+                                                       PortRole::ConnectionPolicyRole);
+    info.captionVisible = portData<bool>(nodeId, portType, index, PortRole::CaptionVisible);
+
+    return info;
+}
+
+void AbstractGraphModel::visitNodes(NodeVisitor const &visitor) const
+{
+    for (NodeId const nodeId : allNodeIds()) {
+        visitor(nodeId);
+    }
+}
+
+std::size_t AbstractGraphModel::connectionCount(NodeId nodeId,
+                                                PortType portType,
+                                                PortIndex index) const
+{
+    return connections(nodeId, portType, index).size();
+}
+
+void AbstractGraphModel::visitConnections(NodeId nodeId,
+                                          PortType portType,
+                                          PortIndex index,
+                                          ConnectionVisitor const &visitor) const
+{
+    for (auto const &connectionId : connections(nodeId, portType, index)) {
+        visitor(connectionId);
+    }
+}
+
+void AbstractGraphModel::visitAllConnections(NodeId nodeId, ConnectionVisitor const &visitor) const
+{
+    for (auto const &connectionId : allConnectionIds(nodeId)) {
+        visitor(connectionId);
+    }
+}
+
 void AbstractGraphModel::portsAboutToBeDeleted(NodeId const nodeId,
                                                PortType const portType,
                                                PortIndex const first,
@@ -102,4 +170,89 @@ void AbstractGraphModel::portsInserted()
     _shiftedByDynamicPortsConnections.clear();
 }
 
+void AbstractGraphModel::beginBatchUpdate()
+{
+    ++_batchDepth;
+}
+
+void AbstractGraphModel::endBatchUpdate()
+{
+    Q_ASSERT(_batchDepth > 0);
+
+    if (_batchDepth == 0 || --_batchDepth > 0)
+        return;
+
+    GraphChanges changes;
+    std::swap(changes, _batchChanges);
+
+    auto always = [](auto const &) { return true; };
+
+    uniqueIds(changes.deletedConnections, always);
+    uniqueIds(changes.deletedNodes, always);
+    uniqueIds(changes.createdNodes, [this](NodeId const nodeId) { return nodeExists(nodeId); });
+    uniqueIds(changes.createdConnections, [this](ConnectionId const &connectionId) {
+        return connectionExists(connectionId);
+    });
+
+    if (changes.empty())
+        return;
+
+    // A batch may end while the signals of an outer one are replayed.
+    bool const outerReplay = _batchReplayActive;
+
+    _batchReplayActive = false;
+    Q_EMIT batchUpdateFinished(changes);
+    _batchReplayActive = true;
+
+    for (auto const &connectionId : changes.deletedConnections) {
+        Q_EMIT connectionDeleted(connectionId);
+    }
+
+    for (NodeId const nodeId : changes.deletedNodes) {
+        Q_EMIT nodeDeleted(nodeId);
+    }
+
+    for (NodeId const nodeId : changes.createdNodes) {
+        Q_EMIT nodeCreated(nodeId);
+    }
+
+    for (auto const &connectionId : changes.createdConnections) {
+        Q_EMIT connectionCreated(connectionId);
+    }
+
+    _batchReplayActive = outerReplay;
+}
+
+void AbstractGraphModel::notifyNodeCreated(NodeId const nodeId)
+{
+    if (_batchDepth > 0)
+        _batchChanges.createdNodes.push_back(nodeId);
+    else
+        Q_EMIT nodeCreated(nodeId);
+}
+
+void AbstractGraphModel::notifyNodeDeleted(NodeId const nodeId)
+{
+    if (_batchDepth > 0)
+        _batchChanges.deletedNodes.push_back(nodeId);
+    else
+        Q_EMIT nodeDeleted(nodeId);
+}
+
+void AbstractGraphModel::notifyConnectionCreated(ConnectionId const connectionId)
+{
+    if (_batchDepth > 0)
+        _batchChanges.createdConnections.push_back(connectionId);
+    else
+        Q_EMIT connectionCreated(connectionId);
+}
+
+void AbstractGraphModel::notifyConnectionDeleted(ConnectionId const connectionId)
+{
+    if (_batchDepth > 0)
+        _batchChanges.deletedConnections.push_back(connectionId);
+    else
+        Q_EMIT connectionDeleted(connectionId);
+}
+
 } // namespace QtNodes
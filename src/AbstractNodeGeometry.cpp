@@ -54,6 +54,21 @@ PortIndex AbstractNodeGeometry::checkPortHit(NodeId const nodeId,
 
     double const tolerance = 2.0 * nodeStyle.ConnectionPointDiameter;
 
+    PortIndex closest = InvalidPortIndex;
+    QPointF position;
+
+    if (closestPort(nodeId, portType, nodePoint, closest, position)) {
+        if (closest == InvalidPortIndex)
+            return result;
+
+        QPointF p = position - nodePoint;
+
+        if (std::sqrt(QPointF::dotProduct(p, p)) < tolerance)
+            result = closest;
+
+        return result;
+    }
+
     size_t const n = _graphModel.nodeData<unsigned int>(nodeId,
                                                         (portType == PortType::Out)
                                                             ? NodeRole::OutPortCount
@@ -74,4 +89,19 @@ PortIndex AbstractNodeGeometry::checkPortHit(NodeId const nodeId,
     return result;
 }
 
+bool AbstractNodeGeometry::closestPort(NodeId const nodeId,
+                                       PortType const portType,
+                                       QPointF const nodePoint,
+                                       PortIndex &closest,
+                                       QPointF &position) const
+{
+    Q_UNUSED(nodeId);
+    Q_UNUSED(portType);
+    Q_UNUSED(nodePoint);
+    Q_UNUSED(closest);
+    Q_UNUSED(position);
+
+    return false;
+}
+
 } // namespace QtNodes
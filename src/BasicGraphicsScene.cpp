@@ -3,17 +3,23 @@
 #include "AbstractNodeGeometry.hpp"
 #include "ConnectionGraphicsObject.hpp"
 #include "ConnectionIdUtils.hpp"
+#include "ConnectionLayerItem.hpp"
 #include "DefaultConnectionPainter.hpp"
 #include "DefaultHorizontalNodeGeometry.hpp"
 #include "DefaultNodePainter.hpp"
 #include "DefaultVerticalNodeGeometry.hpp"
 #include "GraphicsView.hpp"
 #include "NodeGraphicsObject.hpp"
+#include "NodeStyle.hpp"
+#include "StyleCollection.hpp"
+#include "UndoCommands.hpp"
 
 #include <QUndoStack>
 
 #include <QtWidgets/QFileDialog>
+#include <QtWidgets/QGraphicsEffect>
 #include <QtWidgets/QGraphicsSceneMoveEvent>
+#include <QtWidgets/QStyleOptionGraphicsItem>
 
 #include <QtCore/QBuffer>
 #include <QtCore/QByteArray>
@@ -24,6 +30,7 @@
 #include <QtCore/QJsonObject>
 #include <QtCore/QtGlobal>
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include <unordered_set>
@@ -35,11 +42,24 @@ namespace QtNodes {
 BasicGraphicsScene::BasicGraphicsScene(AbstractGraphModel &graphModel, QObject *parent)
     : QGraphicsScene(parent)
     , _graphModel(graphModel)
+    , _connectionBatching(false)
     , _nodeGeometry(std::make_unique<DefaultHorizontalNodeGeometry>(_graphModel))
     , _nodePainter(std::make_unique<DefaultNodePainter>())
     , _connectionPainter(std::make_unique<DefaultConnectionPainter>())
     , _nodeDrag(false)
+    , _nodeDragActive(false)
+    , _connectionUpdatePending(false)
+    , _nodeIndexEnabled(true)
+    , _geometryStyleGeneration(StyleCollection::nodeStyleGeneration())
+    , _reducedDetailScale(0.6)
+    , _minimalDetailScale(0.4)
+    , _viewScale(1.0)
+    , _viewLevelOfDetail(LevelOfDetail::Full)
     , _undoStack(new QUndoStack(this))
+    , _undoMemoryBudget(0)
+    , _undoMemoryUsage(0)
+    , _nodeStatePool(std::make_unique<NodeStatePool>())
+    , _trimmingUndoStack(false)
     , _orientation(Qt::Horizontal)
 {
     setItemIndexMethod(QGraphicsScene::NoIndex);
@@ -74,14 +94,26 @@ BasicGraphicsScene::BasicGraphicsScene(AbstractGraphModel &graphModel, QObject *
             this,
             &BasicGraphicsScene::onNodeUpdated);
 
+    connect(&_graphModel,
+            &AbstractGraphModel::batchUpdateFinished,
+            this,
+            &BasicGraphicsScene::onBatchUpdateFinished);
+
     connect(this, &BasicGraphicsScene::nodeClicked, this, &BasicGraphicsScene::onNodeClicked);
 
+    // Pushing, undoing and redoing all move the index.
+    connect(_undoStack, &QUndoStack::indexChanged, this, &BasicGraphicsScene::trimUndoStack);
+
     connect(&_graphModel, &AbstractGraphModel::modelReset, this, &BasicGraphicsScene::onModelReset);
 
     traverseGraphAndPopulateGraphicsObjects();
 }
 
-BasicGraphicsScene::~BasicGraphicsScene() = default;
+BasicGraphicsScene::~BasicGraphicsScene()
+{
+    // The commands take their memory out of `_undoMemoryUsage` when deleted.
+    delete _undoStack;
+}
 
 AbstractGraphModel const &BasicGraphicsScene::graphModel() const
 {
@@ -116,6 +148,15 @@ void BasicGraphicsScene::setNodePainter(std::unique_ptr<AbstractNodePainter> new
 void BasicGraphicsScene::setConnectionPainter(std::unique_ptr<AbstractConnectionPainter> newPainter)
 {
     _connectionPainter = std::move(newPainter);
+
+    // The connections cache shapes built by the previous painter, which also
+    // decided what to batch; `move()` redoes both.
+    for (auto &cgo : _connectionGraphicsObjects) {
+        cgo.second->move();
+    }
+
+    if (_draftConnection)
+        _draftConnection->update();
 }
 
 QUndoStack &BasicGraphicsScene::undoStack()
@@ -123,6 +164,286 @@ QUndoStack &BasicGraphicsScene::undoStack()
     return *_undoStack;
 }
 
+void BasicGraphicsScene::setNodeIndexEnabled(bool enabled)
+{
+    if (_nodeIndexEnabled == enabled)
+        return;
+
+    _nodeIndexEnabled = enabled;
+
+    _nodeIndex.clear();
+
+    for (auto const &node : _nodeGraphicsObjects) {
+        updateNodeIndex(node.first);
+    }
+}
+
+void BasicGraphicsScene::updateNodeIndex(NodeId const nodeId)
+{
+    if (!_nodeIndexEnabled)
+        return;
+
+    if (auto node = nodeGraphicsObject(nodeId))
+        _nodeIndex.update(nodeId, node->sceneBoundingRect());
+}
+
+NodeStyle const &BasicGraphicsScene::nodeStyle(NodeId const nodeId)
+{
+    unsigned int const generation = StyleCollection::nodeStyleGeneration();
+
+    // Geometries may measure the nodes with the style.
+    if (generation != _geometryStyleGeneration) {
+        _geometryStyleGeneration = generation;
+        _nodeGeometry->invalidateAll();
+    }
+
+    CachedNodeStyle &cached = _nodeStyles[nodeId];
+
+    if (cached.style && cached.generation == generation)
+        return *cached.style;
+
+    QVariant styleData = _graphModel.nodeData(nodeId, NodeRole::Style);
+
+    if (!_lastStyle || styleData != _lastStyleData) {
+        QJsonDocument json = QJsonDocument::fromVariant(styleData);
+
+        _lastStyle = std::make_shared<NodeStyle const>(json.object());
+        _lastStyleData = std::move(styleData);
+    }
+
+    cached.style = _lastStyle;
+    cached.generation = generation;
+
+    return *cached.style;
+}
+
+void BasicGraphicsScene::setConnectionBatching(bool enabled)
+{
+    if (_connectionBatching == enabled)
+        return;
+
+    _connectionBatching = enabled;
+
+    if (enabled)
+        _connectionLayer = std::make_unique<ConnectionLayerItem>(*this);
+
+    for (auto &cgo : _connectionGraphicsObjects) {
+        cgo.second->updateBatching();
+    }
+
+    if (!enabled)
+        _connectionLayer.reset();
+}
+
+void BasicGraphicsScene::setLevelOfDetailThresholds(double reducedScale, double minimalScale)
+{
+    _reducedDetailScale = reducedScale;
+    _minimalDetailScale = std::min(minimalScale, reducedScale);
+
+    setViewScale(_viewScale);
+
+    update();
+}
+
+LevelOfDetail BasicGraphicsScene::levelOfDetail(QTransform const &transform) const
+{
+    return levelOfDetail(QStyleOptionGraphicsItem::levelOfDetailFromTransform(transform));
+}
+
+LevelOfDetail BasicGraphicsScene::levelOfDetail(double scale) const
+{
+    if (scale < _minimalDetailScale)
+        return LevelOfDetail::Minimal;
+
+    if (scale < _reducedDetailScale)
+        return LevelOfDetail::Reduced;
+
+    return LevelOfDetail::Full;
+}
+
+void BasicGraphicsScene::updateViewScale()
+{
+    QList<QGraphicsView *> const attached = views();
+
+    // Without views nothing is painted; keep full detail for the next one.
+    if (attached.isEmpty()) {
+        setViewScale(1.0);
+        return;
+    }
+
+    double scale = 0.0;
+
+    for (QGraphicsView const *view : attached) {
+        scale = std::max(scale, view->transform().m11());
+    }
+
+    setViewScale(scale);
+}
+
+void BasicGraphicsScene::setViewScale(double scale)
+{
+    _viewScale = scale;
+
+    LevelOfDetail const level = levelOfDetail(scale);
+
+    if (level == _viewLevelOfDetail)
+        return;
+
+    bool const shadows = (level == LevelOfDetail::Full);
+
+    if (shadows != (_viewLevelOfDetail == LevelOfDetail::Full)) {
+        for (auto const &node : _nodeGraphicsObjects) {
+            if (auto effect = node.second->graphicsEffect())
+                effect->setEnabled(shadows);
+        }
+    }
+
+    _viewLevelOfDetail = level;
+}
+
+void BasicGraphicsScene::beginNodeDrag()
+{
+    _draggedNodes.clear();
+
+    for (QGraphicsItem *item : selectedItems()) {
+        if (auto n = qgraphicsitem_cast<NodeGraphicsObject *>(item))
+            _draggedNodes.insert(n->nodeId());
+    }
+
+    _dragOffset = QPointF();
+    _nodeDragActive = true;
+}
+
+void BasicGraphicsScene::dragNodes(QPointF const &diff)
+{
+    for (NodeId const nodeId : _draggedNodes) {
+        QPointF const pos = _graphModel.nodeData(nodeId, NodeRole::Position).value<QPointF>();
+
+        _graphModel.setNodeData(nodeId, NodeRole::Position, pos + diff);
+    }
+
+    _dragOffset += diff;
+
+    // The connections are in place before the frame is painted.
+    updateConnections();
+}
+
+void BasicGraphicsScene::endNodeDrag()
+{
+    if (!_nodeDragActive)
+        return;
+
+    _nodeDragActive = false;
+
+    if (!_draggedNodes.empty() && !_dragOffset.isNull())
+        _undoStack->push(new MoveNodeCommand(this, std::move(_draggedNodes), _dragOffset));
+
+    _draggedNodes.clear();
+}
+
+void BasicGraphicsScene::scheduleConnectionUpdate(NodeId const nodeId)
+{
+    _movedNodes.insert(nodeId);
+
+    if (_connectionUpdatePending)
+        return;
+
+    _connectionUpdatePending = true;
+
+    QMetaObject::invokeMethod(this, [this]() { updateConnections(); }, Qt::QueuedConnection);
+}
+
+void BasicGraphicsScene::updateConnections()
+{
+    _connectionUpdatePending = false;
+
+    if (_movedNodes.empty())
+        return;
+
+    // A connection between two moved nodes is updated once.
+    for (NodeId const nodeId : _movedNodes) {
+        _graphModel.visitAllConnections(nodeId, [this](ConnectionId const &connectionId) {
+            _dirtyConnections.insert(connectionId);
+        });
+    }
+
+    _movedNodes.clear();
+
+    for (auto const &connectionId : _dirtyConnections) {
+        if (auto cgo = connectionGraphicsObject(connectionId))
+            cgo->followNodes();
+    }
+
+    _dirtyConnections.clear();
+}
+
+void BasicGraphicsScene::setUndoMemoryBudget(std::size_t bytes)
+{
+    _undoMemoryBudget = bytes;
+
+    trimUndoStack();
+}
+
+std::size_t BasicGraphicsScene::undoMemoryUsage() const
+{
+    return _undoMemoryUsage;
+}
+
+NodeStatePool &BasicGraphicsScene::nodeStatePool()
+{
+    return *_nodeStatePool;
+}
+
+void BasicGraphicsScene::trimUndoStack()
+{
+    if (_trimmingUndoStack)
+        return;
+
+    _trimmingUndoStack = true;
+
+    // Pushing or merging changes the command below the index, undoing the one
+    // at the index; redone commands may keep more or less undo data.
+    int const index = _undoStack->index();
+
+    for (int i : {index - 1, index}) {
+        if (i < 0 || i >= _undoStack->count())
+            continue;
+
+        // QUndoStack only hands out const commands, yet owns them mutably.
+        if (auto command = dynamic_cast<SceneUndoCommand *>(
+                const_cast<QUndoCommand *>(_undoStack->command(i))))
+            command->accountMemory(_undoMemoryUsage);
+    }
+
+    // Discarded commands are removed once undone; doing it here in a row
+    // spares the user undo steps that change nothing.
+    while (_undoStack->index() > 0 && _undoStack->command(_undoStack->index() - 1)->isObsolete())
+        _undoStack->undo();
+
+    if (_undoMemoryBudget > 0) {
+        // Only a prefix of the history can be discarded, and only as far as
+        // every command in it can be: undoing a command whose predecessor was
+        // not restored is not safe.
+        for (int i = 0; i < _undoStack->index() - 1 && _undoMemoryUsage > _undoMemoryBudget;
+             ++i) {
+            // QUndoStack only hands out const commands, yet owns them mutably.
+            auto command = dynamic_cast<SceneUndoCommand *>(
+                const_cast<QUndoCommand *>(_undoStack->command(i)));
+
+            if (!command)
+                break;
+
+            if (command->isObsolete())
+                continue;
+
+            // Takes the command's memory out of `_undoMemoryUsage`.
+            command->discard();
+        }
+    }
+
+    _trimmingUndoStack = false;
+}
+
 std::unique_ptr<ConnectionGraphicsObject> const &BasicGraphicsScene::makeDraftConnection(
     ConnectionId const incompleteConnectionId)
 {
@@ -142,6 +463,8 @@ void BasicGraphicsScene::clearScene()
 {
     auto const &allNodeIds = graphModel().allNodeIds();
 
+    GraphBatchUpdate const batch(graphModel());
+
     for (auto nodeId : allNodeIds) {
         graphModel().deleteNode(nodeId);
     }
@@ -196,26 +519,28 @@ QMenu *BasicGraphicsScene::createSceneMenu(QPointF const scenePos)
 
 void BasicGraphicsScene::traverseGraphAndPopulateGraphicsObjects()
 {
-    auto allNodeIds = _graphModel.allNodeIds();
-
     // First create all the nodes.
-    for (NodeId const nodeId : allNodeIds) {
+    _graphModel.visitNodes([this](NodeId const nodeId) {
         _nodeGraphicsObjects[nodeId] = std::make_unique<NodeGraphicsObject>(*this, nodeId);
-    }
+
+        updateNodeIndex(nodeId);
+    });
 
     // Then for each node check output connections and insert them.
-    for (NodeId const nodeId : allNodeIds) {
+    _graphModel.visitNodes([this](NodeId const nodeId) {
         auto nOutPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::OutPortCount);
 
         for (PortIndex index = 0; index < nOutPorts; ++index) {
-            auto const &outConnectionIds = _graphModel.connections(nodeId, PortType::Out, index);
-
-            for (auto cid : outConnectionIds) {
-                _connectionGraphicsObjects[cid] = std::make_unique<ConnectionGraphicsObject>(*this,
-                                                                                             cid);
-            }
+            _graphModel.visitConnections(nodeId,
+                                         PortType::Out,
+                                         index,
+                                         [this](ConnectionId const &cid) {
+                                             _connectionGraphicsObjects[cid]
+                                                 = std::make_unique<ConnectionGraphicsObject>(*this,
+                                                                                              cid);
+                                         });
         }
-    }
+    });
 }
 
 void BasicGraphicsScene::updateAttachedNodes(ConnectionId const connectionId,
@@ -230,6 +555,10 @@ void BasicGraphicsScene::updateAttachedNodes(ConnectionId const connectionId,
 
 void BasicGraphicsScene::onConnectionDeleted(ConnectionId const connectionId)
 {
+    // Already handled by `onBatchUpdateFinished()`.
+    if (_graphModel.batchReplayActive())
+        return;
+
     auto it = _connectionGraphicsObjects.find(connectionId);
     if (it != _connectionGraphicsObjects.end()) {
         _connectionGraphicsObjects.erase(it);
@@ -248,6 +577,10 @@ void BasicGraphicsScene::onConnectionDeleted(ConnectionId const connectionId)
 
 void BasicGraphicsScene::onConnectionCreated(ConnectionId const connectionId)
 {
+    // Already handled by `onBatchUpdateFinished()`.
+    if (_graphModel.batchReplayActive())
+        return;
+
     _connectionGraphicsObjects[connectionId]
         = std::make_unique<ConnectionGraphicsObject>(*this, connectionId);
 
@@ -259,18 +592,82 @@ void BasicGraphicsScene::onConnectionCreated(ConnectionId const connectionId)
 
 void BasicGraphicsScene::onNodeDeleted(NodeId const nodeId)
 {
+    // Already handled by `onBatchUpdateFinished()`.
+    if (_graphModel.batchReplayActive())
+        return;
+
     auto it = _nodeGraphicsObjects.find(nodeId);
     if (it != _nodeGraphicsObjects.end()) {
         _nodeGraphicsObjects.erase(it);
 
+        _nodeIndex.remove(nodeId);
+        _nodeStyles.erase(nodeId);
+        _nodeGeometry->invalidate(nodeId);
+
         Q_EMIT modified(this);
     }
 }
 
 void BasicGraphicsScene::onNodeCreated(NodeId const nodeId)
 {
+    // Already handled by `onBatchUpdateFinished()`.
+    if (_graphModel.batchReplayActive())
+        return;
+
     _nodeGraphicsObjects[nodeId] = std::make_unique<NodeGraphicsObject>(*this, nodeId);
 
+    updateNodeIndex(nodeId);
+
+    Q_EMIT modified(this);
+}
+
+void BasicGraphicsScene::onBatchUpdateFinished(GraphChanges const &changes)
+{
+    std::unordered_set<NodeId> attachedNodes;
+
+    for (auto const &connectionId : changes.deletedConnections) {
+        _connectionGraphicsObjects.erase(connectionId);
+
+        if (_draftConnection && _draftConnection->connectionId() == connectionId) {
+            _draftConnection.reset();
+        }
+
+        attachedNodes.insert(connectionId.outNodeId);
+        attachedNodes.insert(connectionId.inNodeId);
+    }
+
+    for (NodeId const nodeId : changes.deletedNodes) {
+        _nodeGraphicsObjects.erase(nodeId);
+
+        _nodeIndex.remove(nodeId);
+        _nodeStyles.erase(nodeId);
+        _nodeGeometry->invalidate(nodeId);
+    }
+
+    _nodeGraphicsObjects.reserve(_nodeGraphicsObjects.size() + changes.createdNodes.size());
+
+    for (NodeId const nodeId : changes.createdNodes) {
+        _nodeGraphicsObjects[nodeId] = std::make_unique<NodeGraphicsObject>(*this, nodeId);
+
+        updateNodeIndex(nodeId);
+    }
+
+    _connectionGraphicsObjects.reserve(_connectionGraphicsObjects.size()
+                                       + changes.createdConnections.size());
+
+    for (auto const &connectionId : changes.createdConnections) {
+        _connectionGraphicsObjects[connectionId]
+            = std::make_unique<ConnectionGraphicsObject>(*this, connectionId);
+
+        attachedNodes.insert(connectionId.outNodeId);
+        attachedNodes.insert(connectionId.inNodeId);
+    }
+
+    for (NodeId const nodeId : attachedNodes) {
+        if (auto node = nodeGraphicsObject(nodeId))
+            node->update();
+    }
+
     Q_EMIT modified(this);
 }
 
@@ -279,6 +676,7 @@ void BasicGraphicsScene::onNodePositionUpdated(NodeId const nodeId)
     auto node = nodeGraphicsObject(nodeId);
     if (node) {
         node->setPos(_graphModel.nodeData(nodeId, NodeRole::Position).value<QPointF>());
+        updateNodeIndex(nodeId);
         node->update();
         _nodeDrag = true;
     }
@@ -286,12 +684,15 @@ void BasicGraphicsScene::onNodePositionUpdated(NodeId const nodeId)
 
 void BasicGraphicsScene::onNodeUpdated(NodeId const nodeId)
 {
+    _nodeStyles.erase(nodeId);
+
     auto node = nodeGraphicsObject(nodeId);
 
     if (node) {
         node->setGeometryChanged();
 
         _nodeGeometry->recomputeSize(nodeId);
+        updateNodeIndex(nodeId);
 
         node->updateQWidgetEmbedPos();
         node->update();
@@ -312,9 +713,18 @@ void BasicGraphicsScene::onModelReset()
 {
     _connectionGraphicsObjects.clear();
     _nodeGraphicsObjects.clear();
+    _nodeIndex.clear();
+    _nodeStyles.clear();
+    _nodeGeometry->invalidateAll();
+
+    // `clear()` would delete the layer, which is owned here.
+    _connectionLayer.reset();
 
     clear();
 
+    if (_connectionBatching)
+        _connectionLayer = std::make_unique<ConnectionLayerItem>(*this);
+
     traverseGraphAndPopulateGraphicsObjects();
 }
 
@@ -0,0 +1,348 @@
+#include "BinarySceneFormat.hpp"
+
+#include "ConnectionIdUtils.hpp"
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QtEndian>
+
+#include <cstring>
+
+namespace QtNodes {
+
+namespace {
+
+template<typename T>
+void put(QByteArray &out, T const value)
+{
+    char bytes[sizeof(T)];
+    qToLittleEndian<T>(value, bytes);
+    out.append(bytes, sizeof(T));
+}
+
+void putDouble(QByteArray &out, double const value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put<quint64>(out, bits);
+}
+
+template<typename T>
+T get(char const *data)
+{
+    return qFromLittleEndian<T>(data);
+}
+
+double getDouble(char const *data)
+{
+    quint64 const bits = get<quint64>(data);
+
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+QString const modelNameKey = QStringLiteral("model-name");
+
+} // namespace
+
+namespace BinarySceneFormat {
+
+bool isBinaryScene(char const *data, std::size_t size)
+{
+    return size >= sizeof(Magic) && std::memcmp(data, Magic, sizeof(Magic)) == 0;
+}
+
+bool isBinaryScene(QByteArray const &data)
+{
+    return isBinaryScene(data.constData(), static_cast<std::size_t>(data.size()));
+}
+
+QByteArray fromSceneJson(QJsonObject const &sceneJson)
+{
+    BinarySceneWriter writer;
+
+    for (QJsonValue const nodeValue : sceneJson["nodes"].toArray()) {
+        QJsonObject const nodeJson = nodeValue.toObject();
+        QJsonObject const posJson = nodeJson["position"].toObject();
+
+        writer.addNode(nodeJson["id"].toInt(),
+                       QPointF(posJson["x"].toDouble(), posJson["y"].toDouble()),
+                       nodeJson["internal-data"].toObject());
+    }
+
+    for (QJsonValue const connValue : sceneJson["connections"].toArray()) {
+        writer.addConnection(fromJson(connValue.toObject()));
+    }
+
+    return writer.data();
+}
+
+QJsonObject toSceneJson(QByteArray const &data, QString *errorString)
+{
+    BinarySceneReader const reader(data);
+
+    if (errorString)
+        *errorString = reader.errorString();
+
+    if (!reader.isValid())
+        return {};
+
+    QJsonArray nodesJsonArray;
+    for (std::size_t i = 0; i < reader.nodeCount(); ++i) {
+        QString nodeError;
+        nodesJsonArray.append(reader.nodeJson(i, &nodeError));
+
+        if (!nodeError.isEmpty()) {
+            if (errorString)
+                *errorString = nodeError;
+
+            return {};
+        }
+    }
+
+    QJsonArray connJsonArray;
+    for (std::size_t i = 0; i < reader.connectionCount(); ++i) {
+        connJsonArray.append(toJson(reader.connection(i)));
+    }
+
+    QJsonObject sceneJson;
+    sceneJson["nodes"] = nodesJsonArray;
+    sceneJson["connections"] = connJsonArray;
+
+    return sceneJson;
+}
+
+} // namespace BinarySceneFormat
+
+//-------------------------------------
+
+void BinarySceneWriter::addNode(NodeId const nodeId,
+                                QPointF const &position,
+                                QJsonObject internalData)
+{
+    QString const modelName = internalData.take(modelNameKey).toString();
+
+    auto it = _modelNames.find(modelName);
+    if (it == _modelNames.end())
+        it = _modelNames.emplace(modelName, appendBlob(modelName.toUtf8())).first;
+
+    Range const name = it->second;
+
+    Range const data = internalData.isEmpty()
+                           ? Range{0, 0}
+                           : appendBlob(QJsonDocument(internalData).toJson(QJsonDocument::Compact));
+
+    put<quint32>(_nodeRecords, nodeId);
+    put<quint32>(_nodeRecords, name.length);
+    putDouble(_nodeRecords, position.x());
+    putDouble(_nodeRecords, position.y());
+    put<quint64>(_nodeRecords, name.offset);
+    put<quint64>(_nodeRecords, data.offset);
+    put<quint32>(_nodeRecords, data.length);
+    put<quint32>(_nodeRecords, 0);
+}
+
+void BinarySceneWriter::addConnection(ConnectionId const &connectionId)
+{
+    put<quint32>(_connectionRecords, connectionId.outNodeId);
+    put<quint32>(_connectionRecords, connectionId.outPortIndex);
+    put<quint32>(_connectionRecords, connectionId.inNodeId);
+    put<quint32>(_connectionRecords, connectionId.inPortIndex);
+}
+
+QByteArray BinarySceneWriter::data() const
+{
+    using namespace BinarySceneFormat;
+
+    quint64 const blobOffset = HeaderSize + _nodeRecords.size() + _connectionRecords.size();
+
+    QByteArray out;
+    out.reserve(static_cast<int>(blobOffset + _blobs.size()));
+
+    out.append(Magic, sizeof(Magic));
+    put<quint16>(out, Version);
+    put<quint16>(out, 0);
+    put<quint32>(out, static_cast<quint32>(_nodeRecords.size() / NodeRecordSize));
+    put<quint32>(out, static_cast<quint32>(_connectionRecords.size() / ConnectionRecordSize));
+    put<quint64>(out, blobOffset);
+    put<quint64>(out, static_cast<quint64>(_blobs.size()));
+
+    out.append(_nodeRecords);
+    out.append(_connectionRecords);
+    out.append(_blobs);
+
+    return out;
+}
+
+BinarySceneWriter::Range BinarySceneWriter::appendBlob(QByteArray const &bytes)
+{
+    Range const range{static_cast<quint64>(_blobs.size()), static_cast<quint32>(bytes.size())};
+
+    _blobs.append(bytes);
+
+    return range;
+}
+
+//-------------------------------------
+
+BinarySceneReader::BinarySceneReader(char const *data, std::size_t size)
+    : _data(data)
+    , _nodeCount(0)
+    , _connectionCount(0)
+    , _blobs(nullptr)
+    , _blobSize(0)
+{
+    using namespace BinarySceneFormat;
+
+    if (size < HeaderSize || !isBinaryScene(data, size)) {
+        _errorString = QStringLiteral("Not a binary scene");
+        return;
+    }
+
+    quint16 const version = get<quint16>(data + 4);
+    if (version > Version) {
+        _errorString = QStringLiteral("Unsupported binary scene version %1").arg(version);
+        return;
+    }
+
+    std::size_t const nodeCount = get<quint32>(data + 8);
+    std::size_t const connectionCount = get<quint32>(data + 12);
+    quint64 const blobOffset = get<quint64>(data + 16);
+    quint64 const blobSize = get<quint64>(data + 24);
+
+    quint64 const tablesEnd = HeaderSize + static_cast<quint64>(nodeCount) * NodeRecordSize
+                              + static_cast<quint64>(connectionCount) * ConnectionRecordSize;
+
+    if (blobOffset < tablesEnd || blobOffset > size || blobSize > size - blobOffset) {
+        _errorString = QStringLiteral("Truncated binary scene");
+        return;
+    }
+
+    _nodeCount = nodeCount;
+    _connectionCount = connectionCount;
+    _blobs = data + blobOffset;
+    _blobSize = blobSize;
+
+    // Validating the ranges once lets the accessors trust the records.
+    for (std::size_t i = 0; i < _nodeCount; ++i) {
+        char const *record = nodeRecord(i);
+
+        bool const nameValid = blob(get<quint64>(record + 24), get<quint32>(record + 4)).first;
+        bool const dataValid = blob(get<quint64>(record + 32), get<quint32>(record + 40)).first;
+
+        if (!nameValid || !dataValid) {
+            _errorString = QStringLiteral("Corrupted record of node %1").arg(i);
+            _nodeCount = 0;
+            _connectionCount = 0;
+            return;
+        }
+    }
+}
+
+BinarySceneReader::BinarySceneReader(QByteArray const &data)
+    : BinarySceneReader(data.constData(), static_cast<std::size_t>(data.size()))
+{}
+
+NodeId BinarySceneReader::nodeId(std::size_t const index) const
+{
+    return get<quint32>(nodeRecord(index));
+}
+
+QPointF BinarySceneReader::nodePosition(std::size_t const index) const
+{
+    char const *record = nodeRecord(index);
+
+    return QPointF(getDouble(record + 8), getDouble(record + 16));
+}
+
+QString BinarySceneReader::nodeModelName(std::size_t const index) const
+{
+    char const *record = nodeRecord(index);
+
+    auto const name = blob(get<quint64>(record + 24), get<quint32>(record + 4));
+
+    return QString::fromUtf8(name.first, static_cast<int>(name.second));
+}
+
+QJsonObject BinarySceneReader::nodeInternalData(std::size_t const index,
+                                                QString *errorString) const
+{
+    char const *record = nodeRecord(index);
+
+    auto const data = blob(get<quint64>(record + 32), get<quint32>(record + 40));
+
+    QJsonObject internalData;
+
+    if (errorString)
+        errorString->clear();
+
+    if (data.second > 0) {
+        QByteArray const json = QByteArray::fromRawData(data.first, static_cast<int>(data.second));
+
+        QJsonParseError parseError;
+        QJsonDocument const document = QJsonDocument::fromJson(json, &parseError);
+
+        if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+            if (errorString) {
+                QString const reason = parseError.error != QJsonParseError::NoError
+                                           ? parseError.errorString()
+                                           : QStringLiteral("not a JSON object");
+
+                *errorString = QStringLiteral("Corrupted internal data of node %1: %2")
+                                   .arg(nodeId(index))
+                                   .arg(reason);
+            }
+        } else {
+            internalData = document.object();
+        }
+    }
+
+    internalData[modelNameKey] = nodeModelName(index);
+
+    return internalData;
+}
+
+QJsonObject BinarySceneReader::nodeJson(std::size_t const index, QString *errorString) const
+{
+    QPointF const pos = nodePosition(index);
+
+    QJsonObject posJson;
+    posJson["x"] = pos.x();
+    posJson["y"] = pos.y();
+
+    QJsonObject nodeJson;
+    nodeJson["id"] = static_cast<qint64>(nodeId(index));
+    nodeJson["internal-data"] = nodeInternalData(index, errorString);
+    nodeJson["position"] = posJson;
+
+    return nodeJson;
+}
+
+ConnectionId BinarySceneReader::connection(std::size_t const index) const
+{
+    using namespace BinarySceneFormat;
+
+    char const *record = _data + HeaderSize + _nodeCount * NodeRecordSize
+                         + index * ConnectionRecordSize;
+
+    return ConnectionId{get<quint32>(record),
+                        get<quint32>(record + 4),
+                        get<quint32>(record + 8),
+                        get<quint32>(record + 12)};
+}
+
+char const *BinarySceneReader::nodeRecord(std::size_t const index) const
+{
+    return _data + BinarySceneFormat::HeaderSize + index * BinarySceneFormat::NodeRecordSize;
+}
+
+std::pair<char const *, std::size_t> BinarySceneReader::blob(quint64 offset, quint32 length) const
+{
+    if (offset > _blobSize || length > _blobSize - offset)
+        return {nullptr, 0};
+
+    return {_blobs + offset, length};
+}
+
+} // namespace QtNodes
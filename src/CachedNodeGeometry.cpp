@@ -0,0 +1,158 @@
+#include "CachedNodeGeometry.hpp"
+
+#include "AbstractGraphModel.hpp"
+
+#include <cmath>
+
+namespace QtNodes {
+
+CachedNodeGeometry::CachedNodeGeometry(AbstractGraphModel &graphModel)
+    : AbstractNodeGeometry(graphModel)
+{
+    //
+}
+
+QSize CachedNodeGeometry::size(NodeId const nodeId) const
+{
+    return _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+}
+
+void CachedNodeGeometry::recomputeSize(NodeId const nodeId) const
+{
+    NodeGeometry &geometry = _nodeGeometries[nodeId];
+
+    measure(nodeId, geometry);
+
+    _graphModel.setNodeData(nodeId, NodeRole::Size, measuredSize(nodeId, geometry));
+
+    // Laid out for the size the model actually keeps.
+    geometry.size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+
+    layout(nodeId, geometry);
+}
+
+QPointF CachedNodeGeometry::portPosition(NodeId const nodeId,
+                                         PortType const portType,
+                                         PortIndex const portIndex) const
+{
+    PortGeometry const *port = portGeometry(nodeId, portType, portIndex);
+
+    return port ? port->position : QPointF();
+}
+
+QPointF CachedNodeGeometry::portTextPosition(NodeId const nodeId,
+                                             PortType const portType,
+                                             PortIndex const portIndex) const
+{
+    PortGeometry const *port = portGeometry(nodeId, portType, portIndex);
+
+    return port ? port->textPosition : QPointF();
+}
+
+QPointF CachedNodeGeometry::captionPosition(NodeId const nodeId) const
+{
+    return nodeGeometry(nodeId).captionPosition;
+}
+
+QRectF CachedNodeGeometry::captionRect(NodeId const nodeId) const
+{
+    return nodeGeometry(nodeId).captionRect;
+}
+
+QPointF CachedNodeGeometry::widgetPosition(NodeId const nodeId) const
+{
+    return nodeGeometry(nodeId).widgetPosition;
+}
+
+void CachedNodeGeometry::invalidate(NodeId const nodeId) const
+{
+    _nodeGeometries.erase(nodeId);
+}
+
+void CachedNodeGeometry::invalidateAll() const
+{
+    _nodeGeometries.clear();
+}
+
+bool CachedNodeGeometry::closestPort(NodeId const nodeId,
+                                     PortType const portType,
+                                     QPointF const nodePoint,
+                                     PortIndex &closest,
+                                     QPointF &position) const
+{
+    closest = InvalidPortIndex;
+
+    if (portType == PortType::None)
+        return true;
+
+    auto const &ports = nodeGeometry(nodeId).ports[static_cast<int>(portType)];
+
+    if (ports.empty())
+        return true;
+
+    if (ports.size() == 1) {
+        closest = 0;
+        position = ports.front().position;
+        return true;
+    }
+
+    // Ports are equally spaced along a line.
+    QPointF const first = ports.front().position;
+    QPointF const step = ports[1].position - first;
+
+    double const stepLength2 = QPointF::dotProduct(step, step);
+
+    // Degenerate layout; let `checkPortHit()` test every port.
+    if (!(stepLength2 > 0.0))
+        return false;
+
+    double const t = QPointF::dotProduct(nodePoint - first, step) / stepLength2;
+
+    double const index = std::round(qBound(0.0, t, ports.size() - 1.0));
+
+    closest = static_cast<PortIndex>(index);
+    position = ports[closest].position;
+
+    return true;
+}
+
+CachedNodeGeometry::NodeGeometry const &CachedNodeGeometry::nodeGeometry(NodeId const nodeId) const
+{
+    auto it = _nodeGeometries.find(nodeId);
+
+    if (it != _nodeGeometries.end())
+        return it->second;
+
+    // Unknown and deleted nodes are not cached.
+    if (!_graphModel.nodeExists(nodeId)) {
+        static NodeGeometry const empty{};
+        return empty;
+    }
+
+    // Not laid out by `recomputeSize()` yet, or invalidated since.
+    NodeGeometry &geometry = _nodeGeometries[nodeId];
+
+    measure(nodeId, geometry);
+
+    geometry.size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+
+    layout(nodeId, geometry);
+
+    return geometry;
+}
+
+CachedNodeGeometry::PortGeometry const *CachedNodeGeometry::portGeometry(
+    NodeId const nodeId, PortType const portType, PortIndex const portIndex) const
+{
+    if (portType == PortType::None)
+        return nullptr;
+
+    auto const &ports = nodeGeometry(nodeId).ports[static_cast<int>(portType)];
+
+    if (portIndex >= ports.size())
+        return nullptr;
+
+    return &ports[portIndex];
+}
+
+} // namespace QtNodes
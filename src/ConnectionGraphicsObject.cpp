@@ -5,6 +5,7 @@
 #include "AbstractNodeGeometry.hpp"
 #include "BasicGraphicsScene.hpp"
 #include "ConnectionIdUtils.hpp"
+#include "ConnectionLayerItem.hpp"
 #include "ConnectionState.hpp"
 #include "ConnectionStyle.hpp"
 #include "NodeConnectionInteraction.hpp"
@@ -31,6 +32,10 @@ ConnectionGraphicsObject::ConnectionGraphicsObject(BasicGraphicsScene &scene,
     , _connectionState(*this)
     , _out{0, 0}
     , _in{0, 0}
+    , _nodePosValid(false)
+    , _curveValid(false)
+    , _shapeValid(false)
+    , _batched(false)
 {
     scene.addItem(this);
 
@@ -45,6 +50,21 @@ ConnectionGraphicsObject::ConnectionGraphicsObject(BasicGraphicsScene &scene,
     setZValue(-1.0);
 
     initializePosition();
+
+    updateBatching();
+}
+
+ConnectionGraphicsObject::~ConnectionGraphicsObject()
+{
+    if (!_batched)
+        return;
+
+    BasicGraphicsScene *scene = nodeScene();
+
+    if (ConnectionLayerItem *layer = scene ? scene->connectionLayer() : nullptr) {
+        layer->remove(this);
+        layer->updateConnectionArea(sceneBoundingRect());
+    }
 }
 
 void ConnectionGraphicsObject::initializePosition()
@@ -98,14 +118,9 @@ ConnectionId const &ConnectionGraphicsObject::connectionId() const
 
 QRectF ConnectionGraphicsObject::boundingRect() const
 {
-    auto points = pointsC1C2();
+    updateCurve();
 
-    // `normalized()` fixes inverted rects.
-    QRectF basicRect = QRectF(_out, _in).normalized();
-
-    QRectF c1c2Rect = QRectF(points.first, points.second).normalized();
-
-    QRectF commonRect = basicRect.united(c1c2Rect);
+    QRectF commonRect = _curveRect;
 
     auto const &connectionStyle = StyleCollection::connectionStyle();
     float const diam = connectionStyle.pointDiameter();
@@ -128,7 +143,13 @@ QPainterPath ConnectionGraphicsObject::shape() const
     //return path;
 
 #else
-    return nodeScene()->connectionPainter().getPainterStroke(*this);
+    // Hover and hit tests ask for the shape far more often than the ends move.
+    if (!_shapeValid) {
+        _shape = nodeScene()->connectionPainter().getPainterStroke(*this);
+        _shapeValid = true;
+    }
+
+    return _shape;
 #endif
 }
 
@@ -145,11 +166,18 @@ void ConnectionGraphicsObject::setEndPoint(PortType portType, QPointF const &poi
         _in = point;
     else
         _out = point;
+
+    _curveValid = false;
+    _shapeValid = false;
 }
 
 void ConnectionGraphicsObject::move()
 {
-    auto moveEnd = [this](ConnectionId cId, PortType portType) {
+    updateBatchedArea();
+
+    int movedEnds = 0;
+
+    auto moveEnd = [this, &movedEnds](ConnectionId cId, PortType portType) {
         NodeId nodeId = getNodeId(portType, cId);
 
         if (nodeId == InvalidNodeId)
@@ -168,15 +196,88 @@ void ConnectionGraphicsObject::move()
             QPointF connectionPos = sceneTransform().inverted().map(scenePos);
 
             setEndPoint(portType, connectionPos);
+
+            (portType == PortType::Out ? _outNodePos : _inNodePos) = ngo->pos();
+            ++movedEnds;
         }
     };
 
     moveEnd(_connectionId, PortType::Out);
     moveEnd(_connectionId, PortType::In);
 
+    _nodePosValid = (movedEnds == 2);
+
     prepareGeometryChange();
 
     update();
+
+    updateBatchedArea();
+
+    // The data types of the ports may have changed along with the node.
+    updateBatching();
+}
+
+void ConnectionGraphicsObject::followNodes()
+{
+    BasicGraphicsScene *scene = nodeScene();
+
+    NodeGraphicsObject *outNgo = scene->nodeGraphicsObject(_connectionId.outNodeId);
+    NodeGraphicsObject *inNgo = scene->nodeGraphicsObject(_connectionId.inNodeId);
+
+    if (_nodePosValid && outNgo && inNgo) {
+        QPointF const shift = outNgo->pos() - _outNodePos;
+
+        if (shift == inNgo->pos() - _inNodePos) {
+            // The curve keeps its shape in item coordinates.
+            updateBatchedArea();
+            setPos(pos() + shift);
+            updateBatchedArea();
+
+            _outNodePos += shift;
+            _inNodePos += shift;
+            return;
+        }
+    }
+
+    move();
+}
+
+void ConnectionGraphicsObject::updateBatching()
+{
+    BasicGraphicsScene *scene = nodeScene();
+
+    ConnectionLayerItem *layer = scene ? scene->connectionLayer() : nullptr;
+
+    bool const batched = layer && scene->connectionBatching() && !isSelected()
+                         && !_connectionState.hovered()
+                         && scene->connectionPainter().batchable(*this);
+
+    if (batched == _batched)
+        return;
+
+    if (layer) {
+        if (batched)
+            layer->insert(this);
+        else
+            layer->remove(this);
+
+        layer->updateConnectionArea(sceneBoundingRect());
+    }
+
+    _batched = batched;
+
+    setFlag(QGraphicsItem::ItemHasNoContents, batched);
+
+    update();
+}
+
+void ConnectionGraphicsObject::updateBatchedArea() const
+{
+    if (!_batched)
+        return;
+
+    if (ConnectionLayerItem *layer = nodeScene()->connectionLayer())
+        layer->updateConnectionArea(sceneBoundingRect());
 }
 
 ConnectionState const &ConnectionGraphicsObject::connectionState() const
@@ -189,6 +290,14 @@ ConnectionState &ConnectionGraphicsObject::connectionState()
     return _connectionState;
 }
 
+QVariant ConnectionGraphicsObject::itemChange(GraphicsItemChange change, QVariant const &value)
+{
+    if (change == ItemSelectedHasChanged)
+        updateBatching();
+
+    return QGraphicsObject::itemChange(change, value);
+}
+
 void ConnectionGraphicsObject::paint(QPainter *painter,
                                      QStyleOptionGraphicsItem const *option,
                                      QWidget *)
@@ -267,6 +376,8 @@ void ConnectionGraphicsObject::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
 {
     _connectionState.setHovered(true);
 
+    updateBatching();
+
     update();
 
     // Signal
@@ -279,6 +390,8 @@ void ConnectionGraphicsObject::hoverLeaveEvent(QGraphicsSceneHoverEvent *event)
 {
     _connectionState.setHovered(false);
 
+    updateBatching();
+
     update();
 
     // Signal
@@ -289,17 +402,48 @@ void ConnectionGraphicsObject::hoverLeaveEvent(QGraphicsSceneHoverEvent *event)
 
 std::pair<QPointF, QPointF> ConnectionGraphicsObject::pointsC1C2() const
 {
+    updateCurve();
+
+    return _c1c2;
+}
+
+QPainterPath const &ConnectionGraphicsObject::cubicPath() const
+{
+    updateCurve();
+
+    return _cubic;
+}
+
+void ConnectionGraphicsObject::updateCurve() const
+{
+    if (_curveValid)
+        return;
+
     switch (nodeScene()->orientation()) {
     case Qt::Horizontal:
-        return pointsC1C2Horizontal();
+        _c1c2 = pointsC1C2Horizontal();
         break;
 
     case Qt::Vertical:
-        return pointsC1C2Vertical();
+        _c1c2 = pointsC1C2Vertical();
         break;
+
+    default:
+        throw std::logic_error("Unreachable code after switch statement");
     }
 
-    throw std::logic_error("Unreachable code after switch statement");
+    // cubic spline
+    _cubic = QPainterPath(_out);
+    _cubic.cubicTo(_c1c2.first, _c1c2.second, _in);
+
+    // `normalized()` fixes inverted rects.
+    QRectF basicRect = QRectF(_out, _in).normalized();
+
+    QRectF c1c2Rect = QRectF(_c1c2.first, _c1c2.second).normalized();
+
+    _curveRect = basicRect.united(c1c2Rect);
+
+    _curveValid = true;
 }
 
 void ConnectionGraphicsObject::addGraphicsEffect()
@@ -0,0 +1,113 @@
+#include "ConnectionLayerItem.hpp"
+
+#include "AbstractConnectionPainter.hpp"
+#include "BasicGraphicsScene.hpp"
+#include "ConnectionGraphicsObject.hpp"
+
+#include <QtCore/QMetaObject>
+#include <QtWidgets/QStyleOptionGraphicsItem>
+
+namespace QtNodes {
+
+ConnectionLayerItem::ConnectionLayerItem(BasicGraphicsScene &scene)
+    : _scene(scene)
+    , _boundsUpdatePending(false)
+{
+    scene.addItem(this);
+
+    // `exposedRect` is needed to skip the connections outside the exposed area.
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+
+    setAcceptedMouseButtons(Qt::NoButton);
+    setAcceptHoverEvents(false);
+
+    setZValue(-2.0);
+}
+
+QRectF ConnectionLayerItem::boundingRect() const
+{
+    return _bounds;
+}
+
+QPainterPath ConnectionLayerItem::shape() const
+{
+    return QPainterPath();
+}
+
+void ConnectionLayerItem::insert(ConnectionGraphicsObject const *cgo)
+{
+    _connections.insert(cgo);
+}
+
+void ConnectionLayerItem::remove(ConnectionGraphicsObject const *cgo)
+{
+    _connections.erase(cgo);
+}
+
+void ConnectionLayerItem::updateConnectionArea(QRectF const &sceneRect)
+{
+    if (!_bounds.contains(sceneRect)) {
+        prepareGeometryChange();
+
+        _bounds = _bounds.isNull() ? sceneRect : _bounds.united(sceneRect);
+    }
+
+    // Areas inside the bounds cannot shrink them; the check spares a pass
+    // over all the connections on most moves.
+    bool const atEdge = sceneRect.left() <= _bounds.left() || sceneRect.top() <= _bounds.top()
+                        || sceneRect.right() >= _bounds.right()
+                        || sceneRect.bottom() >= _bounds.bottom();
+
+    if (atEdge && !_boundsUpdatePending) {
+        _boundsUpdatePending = true;
+
+        // The layer may be replaced before the call, the scene outlives it.
+        BasicGraphicsScene *scene = &_scene;
+
+        QMetaObject::invokeMethod(
+            scene,
+            [scene]() {
+                if (ConnectionLayerItem *layer = scene->connectionLayer())
+                    layer->updateBounds();
+            },
+            Qt::QueuedConnection);
+    }
+
+    update(sceneRect);
+}
+
+void ConnectionLayerItem::updateBounds()
+{
+    _boundsUpdatePending = false;
+
+    QRectF bounds;
+
+    for (ConnectionGraphicsObject const *cgo : _connections) {
+        QRectF const rect = cgo->sceneBoundingRect();
+
+        bounds = bounds.isNull() ? rect : bounds.united(rect);
+    }
+
+    if (bounds != _bounds) {
+        prepareGeometryChange();
+
+        _bounds = bounds;
+    }
+}
+
+void ConnectionLayerItem::paint(QPainter *painter,
+                                QStyleOptionGraphicsItem const *option,
+                                QWidget *)
+{
+    _visible.clear();
+
+    for (ConnectionGraphicsObject const *cgo : _connections) {
+        if (cgo->sceneBoundingRect().intersects(option->exposedRect))
+            _visible.push_back(cgo);
+    }
+
+    if (!_visible.empty())
+        _scene.connectionPainter().paintBatch(painter, _visible);
+}
+
+} // namespace QtNodes
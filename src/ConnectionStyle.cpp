@@ -172,6 +172,19 @@ QColor ConnectionStyle::normalColor(QString typeId) const
     return QColor::fromHsl(hue, sat, 160);
 }
 
+QColor ConnectionStyle::normalColor(QString const &typeId, unsigned int typeHandle) const
+{
+    if (typeHandle >= _typeColors.size())
+        _typeColors.resize(typeHandle + 1);
+
+    QColor &color = _typeColors[typeHandle];
+
+    if (!color.isValid())
+        color = normalColor(typeId);
+
+    return color;
+}
+
 QColor ConnectionStyle::selectedColor() const
 {
     return SelectedColor;
@@ -1,35 +1,78 @@
 #include "DataFlowGraphModel.hpp"
+#include "BinarySceneFormat.hpp"
 #include "ConnectionIdHash.hpp"
+#include "GraphEvaluationScheduler.hpp"
+#include "WorkStealingThreadPool.hpp"
 
+#include <QDebug>
+#include <QFile>
 #include <QJsonArray>
+#include <QJsonDocument>
+#include <QThread>
+#include <QTimer>
 
+#include <algorithm>
 #include <stdexcept>
+#include <thread>
 
 namespace QtNodes {
 
+struct DataFlowGraphModel::MappedScene
+{
+    QFile file;
+
+    std::unique_ptr<BinarySceneReader> reader;
+
+    std::size_t pendingNodes = 0;
+};
+
+namespace {
+
+/// Set while a node evaluated by the graph is inside `setInDataBatch()`.
+thread_local DataFlowGraphModel const *evaluatingModel = nullptr;
+
+} // namespace
+
 DataFlowGraphModel::DataFlowGraphModel(std::shared_ptr<NodeDelegateModelRegistry> registry)
     : _registry(std::move(registry))
     , _nextNodeId{0}
-{}
+    , _propagationMode{PropagationMode::Immediate}
+    , _propagationScheduled{false}
+    , _propagating{false}
+    , _threadCount{0}
+{
+    connect(this, &DataFlowGraphModel::nodeUpdated, this, &DataFlowGraphModel::invalidatePortInfo);
+}
+
+DataFlowGraphModel::~DataFlowGraphModel() = default;
 
 std::unordered_set<NodeId> DataFlowGraphModel::allNodeIds() const
 {
-    std::unordered_set<NodeId> nodeIds;
-    for_each(_models.begin(), _models.end(), [&nodeIds](auto const &p) { nodeIds.insert(p.first); });
+    return std::unordered_set<NodeId>(_nodeIds.begin(), _nodeIds.end());
+}
 
-    return nodeIds;
+void DataFlowGraphModel::visitNodes(NodeVisitor const &visitor) const
+{
+    for (NodeId const nodeId : _nodeIds) {
+        visitor(nodeId);
+    }
 }
 
 std::unordered_set<ConnectionId> DataFlowGraphModel::allConnectionIds(NodeId const nodeId) const
 {
     std::unordered_set<ConnectionId> result;
 
-    std::copy_if(_connectivity.begin(),
-                 _connectivity.end(),
-                 std::inserter(result, std::end(result)),
-                 [&nodeId](ConnectionId const &cid) {
-                     return cid.inNodeId == nodeId || cid.outNodeId == nodeId;
-                 });
+    NodeEntry const *entry = nodeEntry(nodeId);
+    if (entry == nullptr)
+        return result;
+
+    // A node connected to itself has its connections listed on both sides,
+    // the set removes such duplicates.
+    for (auto const *ports : {&entry->connections.in, &entry->connections.out}) {
+        for (auto const &attached : *ports) {
+            result.insert(attached.begin(), attached.end());
+        }
+    }
 
     return result;
 }
@@ -40,17 +83,170 @@ std::unordered_set<ConnectionId> DataFlowGraphModel::connections(NodeId nodeId,
 {
     std::unordered_set<ConnectionId> result;
 
-    std::copy_if(_connectivity.begin(),
-                 _connectivity.end(),
-                 std::inserter(result, std::end(result)),
-                 [&portType, &portIndex, &nodeId](ConnectionId const &cid) {
-                     return (getNodeId(portType, cid) == nodeId
-                             && getPortIndex(portType, cid) == portIndex);
-                 });
+    if (auto const *attached = portConnections(nodeId, portType, portIndex)) {
+        result.insert(attached->begin(), attached->end());
+    }
 
     return result;
 }
 
+std::size_t DataFlowGraphModel::connectionCount(NodeId nodeId,
+                                                PortType portType,
+                                                PortIndex portIndex) const
+{
+    auto const *attached = portConnections(nodeId, portType, portIndex);
+
+    return attached ? attached->size() : 0u;
+}
+
+void DataFlowGraphModel::visitConnections(NodeId nodeId,
+                                          PortType portType,
+                                          PortIndex portIndex,
+                                          ConnectionVisitor const &visitor) const
+{
+    if (auto const *attached = portConnections(nodeId, portType, portIndex)) {
+        for (auto const &connectionId : *attached) {
+            visitor(connectionId);
+        }
+    }
+}
+
+void DataFlowGraphModel::visitAllConnections(NodeId nodeId, ConnectionVisitor const &visitor) const
+{
+    NodeEntry const *entry = nodeEntry(nodeId);
+    if (entry == nullptr)
+        return;
+
+    for (auto const &attached : entry->connections.in) {
+        for (auto const &connectionId : attached) {
+            visitor(connectionId);
+        }
+    }
+
+    for (auto const &attached : entry->connections.out) {
+        for (auto const &connectionId : attached) {
+            // Connections of a node to itself were already visited as inputs.
+            if (connectionId.inNodeId != nodeId)
+                visitor(connectionId);
+        }
+    }
+}
+
+std::vector<ConnectionId> const *DataFlowGraphModel::portConnections(NodeId const nodeId,
+                                                                     PortType const portType,
+                                                                     PortIndex const portIndex) const
+{
+    NodeEntry const *entry = nodeEntry(nodeId);
+    if (entry == nullptr)
+        return nullptr;
+
+    auto const &ports = (portType == PortType::Out) ? entry->connections.out
+                                                    : entry->connections.in;
+
+    if (portType == PortType::None || portIndex >= ports.size() || ports[portIndex].empty())
+        return nullptr;
+
+    return &ports[portIndex];
+}
+
+void DataFlowGraphModel::indexConnection(ConnectionId const connectionId)
+{
+    for (PortType const portType : {PortType::Out, PortType::In}) {
+        NodeEntry *entry = nodeEntry(getNodeId(portType, connectionId));
+        if (entry == nullptr)
+            continue;
+
+        auto &ports = (portType == PortType::Out) ? entry->connections.out
+                                                  : entry->connections.in;
+
+        PortIndex const portIndex = getPortIndex(portType, connectionId);
+
+        if (ports.size() <= portIndex)
+            ports.resize(portIndex + 1);
+
+        ports[portIndex].push_back(connectionId);
+    }
+}
+
+void DataFlowGraphModel::unindexConnection(ConnectionId const connectionId)
+{
+    for (PortType const portType : {PortType::Out, PortType::In}) {
+        NodeEntry *entry = nodeEntry(getNodeId(portType, connectionId));
+        if (entry == nullptr)
+            continue;
+
+        auto &ports = (portType == PortType::Out) ? entry->connections.out
+                                                  : entry->connections.in;
+
+        PortIndex const portIndex = getPortIndex(portType, connectionId);
+        if (portIndex >= ports.size())
+            continue;
+
+        auto &attached = ports[portIndex];
+
+        auto cit = std::find(attached.begin(), attached.end(), connectionId);
+        if (cit != attached.end()) {
+            *cit = attached.back();
+            attached.pop_back();
+        }
+
+        // Keeps the index compact after removing ports with dynamic_ports-like models.
+        while (!ports.empty() && ports.back().empty())
+            ports.pop_back();
+    }
+}
+
+void DataFlowGraphModel::insertNode(NodeId const nodeId, std::unique_ptr<NodeDelegateModel> model)
+{
+    if (nodeId == InvalidNodeId)
+        throw std::logic_error("Invalid node id");
+
+    if (nodeEntry(nodeId) != nullptr)
+        throw std::logic_error("Node id " + std::to_string(nodeId) + " is already in use");
+
+    // Keeps ids read from files from allocating huge dense ranges.
+    std::size_t const denseLimit = 2 * _nodeIds.size() + 1024;
+
+    NodeEntry *entry = nullptr;
+
+    if (nodeId < _nodes.size()) {
+        entry = &_nodes[nodeId];
+    } else if (nodeId < denseLimit) {
+        _nodes.resize(static_cast<std::size_t>(nodeId) + 1);
+        entry = &_nodes[nodeId];
+    } else {
+        entry = &_sparseNodes[nodeId];
+    }
+
+    entry->model = std::move(model);
+    entry->denseIndex = _nodeIds.size();
+
+    _nodeIds.push_back(nodeId);
+}
+
+void DataFlowGraphModel::eraseNode(NodeId const nodeId)
+{
+    NodeEntry *entry = nodeEntry(nodeId);
+
+    // Swap-remove from the dense id list.
+    NodeId const movedId = _nodeIds.back();
+    _nodeIds[entry->denseIndex] = movedId;
+    nodeEntry(movedId)->denseIndex = entry->denseIndex;
+    _nodeIds.pop_back();
+
+    // The model is destroyed after its slot is cleared.
+    std::unique_ptr<NodeDelegateModel> model = std::move(entry->model);
+
+    if (nodeId < _nodes.size() && entry == &_nodes[nodeId]) {
+        *entry = NodeEntry();
+
+        while (!_nodes.empty() && !_nodes.back().model)
+            _nodes.pop_back();
+    } else {
+        _sparseNodes.erase(nodeId);
+    }
+}
+
 bool DataFlowGraphModel::connectionExists(ConnectionId const connectionId) const
 {
     return (_connectivity.find(connectionId) != _connectivity.end());
@@ -63,74 +259,130 @@ NodeId DataFlowGraphModel::addNode(QString const nodeType)
     if (model) {
         NodeId newId = newNodeId();
 
-        connect(model.get(),
-                &NodeDelegateModel::dataUpdated,
-                [newId, this](PortIndex const portIndex) {
-                    onOutPortDataUpdated(newId, portIndex);
-                });
+        connectNodeModel(newId, model.get());
+
+        insertNode(newId, std::move(model));
+
+        notifyNodeCreated(newId);
+
+        return newId;
+    }
+
+    return InvalidNodeId;
+}
+
+void DataFlowGraphModel::connectNodeModel(NodeId const nodeId, NodeDelegateModel *model)
+{
+    connect(model, &NodeDelegateModel::dataUpdated, [nodeId, this](PortIndex const portIndex) {
+        onOutPortDataUpdated(nodeId, portIndex);
+    });
+
+    connect(model, &NodeDelegateModel::computingStarted, this, [nodeId, this]() {
+        Q_EMIT nodeComputingStarted(nodeId);
+    });
+
+    connect(model, &NodeDelegateModel::computingFinished, this, [nodeId, this]() {
+        Q_EMIT nodeComputingFinished(nodeId);
+    });
 
-        connect(model.get(),
-                &NodeDelegateModel::portsAboutToBeDeleted,
-                this,
-                [newId, this](PortType const portType, PortIndex const first, PortIndex const last) {
-                    portsAboutToBeDeleted(newId, portType, first, last);
-                });
+    // The node is measured and laid out again for the new widget size.
+    connect(model, &NodeDelegateModel::embeddedWidgetSizeUpdated, this, [nodeId, this]() {
+        Q_EMIT nodeUpdated(nodeId);
+    });
 
-        connect(model.get(),
-                &NodeDelegateModel::portsDeleted,
-                this,
-                &DataFlowGraphModel::portsDeleted);
+    connect(model, &NodeDelegateModel::portsUpdated, this, [nodeId, this]() {
+        Q_EMIT nodeUpdated(nodeId);
+    });
 
-        connect(model.get(),
-                &NodeDelegateModel::portsAboutToBeInserted,
-                this,
-                [newId, this](PortType const portType, PortIndex const first, PortIndex const last) {
-                    portsAboutToBeInserted(newId, portType, first, last);
-                });
+    connect(model,
+            &NodeDelegateModel::portsAboutToBeDeleted,
+            this,
+            [nodeId, this](PortType const portType, PortIndex const first, PortIndex const last) {
+                invalidatePortInfo(nodeId);
+                portsAboutToBeDeleted(nodeId, portType, first, last);
+            });
 
-        connect(model.get(),
-                &NodeDelegateModel::portsInserted,
-                this,
-                &DataFlowGraphModel::portsInserted);
+    connect(model, &NodeDelegateModel::portsDeleted, this, [nodeId, this]() {
+        invalidatePortInfo(nodeId);
+        portsDeleted();
 
-        _models[newId] = std::move(model);
+        // The node has to be measured and laid out again.
+        Q_EMIT nodeUpdated(nodeId);
+    });
 
-        Q_EMIT nodeCreated(newId);
+    connect(model,
+            &NodeDelegateModel::portsAboutToBeInserted,
+            this,
+            [nodeId, this](PortType const portType, PortIndex const first, PortIndex const last) {
+                invalidatePortInfo(nodeId);
+                portsAboutToBeInserted(nodeId, portType, first, last);
+            });
 
-        return newId;
+    connect(model, &NodeDelegateModel::portsInserted, this, [nodeId, this]() {
+        invalidatePortInfo(nodeId);
+        portsInserted();
+
+        // The node has to be measured and laid out again.
+        Q_EMIT nodeUpdated(nodeId);
+    });
+}
+
+bool DataFlowGraphModel::connectionValid(ConnectionId const connectionId) const
+{
+    for (PortType const portType : {PortType::Out, PortType::In}) {
+        NodeEntry const *entry = nodeEntry(getNodeId(portType, connectionId));
+        if (entry == nullptr)
+            return false;
+
+        PortIndex const portIndex = getPortIndex(portType, connectionId);
+
+        if (portIndex >= entry->model->nPorts(portType)) {
+            // The ports of a mapped node may depend on its internal data.
+            if (!entry->mapped)
+                return false;
+
+            materialize(*entry);
+
+            if (portIndex >= entry->model->nPorts(portType))
+                return false;
+        }
     }
 
-    return InvalidNodeId;
+    return true;
 }
 
 bool DataFlowGraphModel::connectionPossible(ConnectionId const connectionId) const
 {
-    auto getDataType = [&](PortType const portType) {
-        return portData(getNodeId(portType, connectionId),
-                        portType,
-                        getPortIndex(portType, connectionId),
-                        PortRole::DataType)
-            .value<NodeDataType>();
-    };
+    if (!connectionValid(connectionId))
+        return false;
+
+    PortInfo const outInfo = portInfo(connectionId.outNodeId,
+                                      PortType::Out,
+                                      connectionId.outPortIndex);
 
-    auto portVacant = [&](PortType const portType) {
+    PortInfo const inInfo = portInfo(connectionId.inNodeId, PortType::In, connectionId.inPortIndex);
+
+    auto portVacant = [&](PortType const portType, PortInfo const &info) {
         NodeId const nodeId = getNodeId(portType, connectionId);
         PortIndex const portIndex = getPortIndex(portType, connectionId);
-        auto const connected = connections(nodeId, portType, portIndex);
-
-        auto policy = portData(nodeId, portType, portIndex, PortRole::ConnectionPolicyRole)
-                          .value<ConnectionPolicy>();
+        if (portConnections(nodeId, portType, portIndex) == nullptr)
+            return true;
 
-        return connected.empty() || (policy == ConnectionPolicy::Many);
+        return info.connectionPolicy == ConnectionPolicy::Many;
     };
 
-    return getDataType(PortType::Out).id == getDataType(PortType::In).id
-           && portVacant(PortType::Out) && portVacant(PortType::In);
+    return outInfo.typeHandle == inInfo.typeHandle && portVacant(PortType::Out, outInfo)
+           && portVacant(PortType::In, inInfo);
 }
 
 void DataFlowGraphModel::addConnection(ConnectionId const connectionId)
 {
-    _connectivity.insert(connectionId);
+    // Connections read from files are not checked by `connectionPossible()`.
+    if (!connectionValid(connectionId))
+        return;
+
+    if (_connectivity.insert(connectionId).second)
+        indexConnection(connectionId);
 
     sendConnectionCreation(connectionId);
 
@@ -148,13 +400,13 @@ void DataFlowGraphModel::addConnection(ConnectionId const connectionId)
 
 void DataFlowGraphModel::sendConnectionCreation(ConnectionId const connectionId)
 {
-    Q_EMIT connectionCreated(connectionId);
+    notifyConnectionCreated(connectionId);
 
-    auto iti = _models.find(connectionId.inNodeId);
-    auto ito = _models.find(connectionId.outNodeId);
-    if (iti != _models.end() && ito != _models.end()) {
-        auto &modeli = iti->second;
-        auto &modelo = ito->second;
+    NodeEntry *in = nodeEntry(connectionId.inNodeId);
+    NodeEntry *out = nodeEntry(connectionId.outNodeId);
+    if (in && out) {
+        NodeDelegateModel *modeli = in->model.get();
+        NodeDelegateModel *modelo = out->model.get();
         modeli->inputConnectionCreated(connectionId);
         modelo->outputConnectionCreated(connectionId);
     }
@@ -162,13 +414,13 @@ void DataFlowGraphModel::sendConnectionCreation(ConnectionId const connectionId)
 
 void DataFlowGraphModel::sendConnectionDeletion(ConnectionId const connectionId)
 {
-    Q_EMIT connectionDeleted(connectionId);
+    notifyConnectionDeleted(connectionId);
 
-    auto iti = _models.find(connectionId.inNodeId);
-    auto ito = _models.find(connectionId.outNodeId);
-    if (iti != _models.end() && ito != _models.end()) {
-        auto &modeli = iti->second;
-        auto &modelo = ito->second;
+    NodeEntry *in = nodeEntry(connectionId.inNodeId);
+    NodeEntry *out = nodeEntry(connectionId.outNodeId);
+    if (in && out) {
+        NodeDelegateModel *modeli = in->model.get();
+        NodeDelegateModel *modelo = out->model.get();
         modeli->inputConnectionDeleted(connectionId);
         modelo->outputConnectionDeleted(connectionId);
     }
@@ -176,18 +428,22 @@ void DataFlowGraphModel::sendConnectionDeletion(ConnectionId const connectionId)
 
 bool DataFlowGraphModel::nodeExists(NodeId const nodeId) const
 {
-    return (_models.find(nodeId) != _models.end());
+    return nodeEntry(nodeId) != nullptr;
 }
 
 QVariant DataFlowGraphModel::nodeData(NodeId nodeId, NodeRole role) const
 {
     QVariant result;
 
-    auto it = _models.find(nodeId);
-    if (it == _models.end())
+    NodeEntry const *entry = nodeEntry(nodeId);
+    if (entry == nullptr)
         return result;
 
-    auto &model = it->second;
+    // The geometry and the type do not depend on the internal data.
+    if (role != NodeRole::Type && role != NodeRole::Position && role != NodeRole::Size)
+        materialize(*entry);
+
+    auto &model = entry->model;
 
     switch (role) {
     case NodeRole::Type:
@@ -195,11 +451,11 @@ QVariant DataFlowGraphModel::nodeData(NodeId nodeId, NodeRole role) const
         break;
 
     case NodeRole::Position:
-        result = _nodeGeometryData[nodeId].pos;
+        result = entry->geometry.pos;
         break;
 
     case NodeRole::Size:
-        result = _nodeGeometryData[nodeId].size;
+        result = entry->geometry.size;
         break;
 
     case NodeRole::CaptionVisible:
@@ -218,7 +474,7 @@ QVariant DataFlowGraphModel::nodeData(NodeId nodeId, NodeRole role) const
     case NodeRole::InternalData: {
         QJsonObject nodeJson;
 
-        nodeJson["internal-data"] = _models.at(nodeId)->save();
+        nodeJson["internal-data"] = internalData(*entry);
 
         result = nodeJson.toVariantMap();
         break;
@@ -250,9 +506,13 @@ QVariant DataFlowGraphModel::nodeData(NodeId nodeId, NodeRole role) const
 
 NodeFlags DataFlowGraphModel::nodeFlags(NodeId nodeId) const
 {
-    auto it = _models.find(nodeId);
+    NodeEntry const *entry = nodeEntry(nodeId);
+    if (entry == nullptr)
+        return NodeFlag::NoFlags;
+
+    materialize(*entry);
 
-    if (it != _models.end() && it->second->widgetEmbeddable() && it->second->resizable())
+    if (entry->model->widgetEmbeddable() && entry->model->resizable())
         return NodeFlag::Resizable;
 
     return NodeFlag::NoFlags;
@@ -266,11 +526,15 @@ bool DataFlowGraphModel::setNodeData(NodeId nodeId, NodeRole role, QVariant valu
 
     bool result = false;
 
+    NodeEntry *entry = nodeEntry(nodeId);
+    if (entry == nullptr)
+        return result;
+
     switch (role) {
     case NodeRole::Type:
         break;
     case NodeRole::Position: {
-        _nodeGeometryData[nodeId].pos = value.value<QPointF>();
+        entry->geometry.pos = value.value<QPointF>();
 
         Q_EMIT nodePositionUpdated(nodeId);
 
@@ -278,7 +542,7 @@ bool DataFlowGraphModel::setNodeData(NodeId nodeId, NodeRole role, QVariant valu
     } break;
 
     case NodeRole::Size: {
-        _nodeGeometryData[nodeId].size = value.value<QSize>();
+        entry->geometry.size = value.value<QSize>();
         result = true;
     } break;
 
@@ -301,11 +565,11 @@ bool DataFlowGraphModel::setNodeData(NodeId nodeId, NodeRole role, QVariant valu
         break;
 
     case NodeRole::WidgetEmbeddable: {
-        auto it = _models.find(nodeId);
-        auto &model = it->second;
+        materialize(*entry);
+
+        auto &model = entry->model;
         model->WidgetEmbeddable=value.toBool();
         model->embeddedWidgetSizeUpdated();
-        Q_EMIT nodeUpdated(nodeId);
         result = true;
     }
         break;
@@ -326,11 +590,13 @@ QVariant DataFlowGraphModel::portData(NodeId nodeId,
 {
     QVariant result;
 
-    auto it = _models.find(nodeId);
-    if (it == _models.end())
+    NodeEntry const *entry = nodeEntry(nodeId);
+    if (entry == nullptr)
         return result;
 
-    auto &model = it->second;
+    materialize(*entry);
+
+    auto &model = entry->model;
 
     switch (role) {
     case PortRole::Data:
@@ -339,19 +605,19 @@ QVariant DataFlowGraphModel::portData(NodeId nodeId,
         break;
 
     case PortRole::DataType:
-        result = QVariant::fromValue(model->dataType(portType, portIndex));
+        result = QVariant::fromValue(portInfo(nodeId, portType, portIndex).dataType);
         break;
 
     case PortRole::ConnectionPolicyRole:
-        result = QVariant::fromValue(model->portConnectionPolicy(portType, portIndex));
+        result = QVariant::fromValue(portInfo(nodeId, portType, portIndex).connectionPolicy);
         break;
 
     case PortRole::CaptionVisible:
-        result = model->portCaptionVisible(portType, portIndex);
+        result = portInfo(nodeId, portType, portIndex).captionVisible;
         break;
 
     case PortRole::Caption:
-        result = model->portCaption(portType, portIndex);
+        result = portInfo(nodeId, portType, portIndex).caption;
 
         break;
 
@@ -362,6 +628,59 @@ QVariant DataFlowGraphModel::portData(NodeId nodeId,
     return result;
 }
 
+PortInfo DataFlowGraphModel::portInfo(NodeId nodeId, PortType portType, PortIndex portIndex) const
+{
+    NodeEntry const *entry = nodeEntry(nodeId);
+    if (entry == nullptr)
+        return PortInfo();
+
+    materialize(*entry);
+
+    auto const &table = portInfoTable(*entry, portType);
+
+    if (portIndex >= table.size())
+        return PortInfo();
+
+    return table[portIndex];
+}
+
+void DataFlowGraphModel::invalidatePortInfo(NodeId const nodeId)
+{
+    if (NodeEntry *entry = nodeEntry(nodeId)) {
+        entry->portInfoValid = false;
+    }
+}
+
+std::vector<PortInfo> const &DataFlowGraphModel::portInfoTable(NodeEntry const &entry,
+                                                                PortType portType) const
+{
+    if (!entry.portInfoValid) {
+        auto const &model = entry.model;
+
+        for (PortType const type : {PortType::In, PortType::Out}) {
+            auto &table = (type == PortType::In) ? entry.inPortInfo : entry.outPortInfo;
+
+            unsigned int const n = model->nPorts(type);
+
+            table.resize(n);
+
+            for (PortIndex portIndex = 0; portIndex < n; ++portIndex) {
+                PortInfo &info = table[portIndex];
+
+                info.dataType = model->dataType(type, portIndex);
+                info.typeHandle = NodeDataType::intern(info.dataType.id);
+                info.caption = model->portCaption(type, portIndex);
+                info.connectionPolicy = model->portConnectionPolicy(type, portIndex);
+                info.captionVisible = model->portCaptionVisible(type, portIndex);
+            }
+        }
+
+        entry.portInfoValid = true;
+    }
+
+    return (portType == PortType::Out) ? entry.outPortInfo : entry.inPortInfo;
+}
+
 bool DataFlowGraphModel::setPortData(
     NodeId nodeId, PortType portType, PortIndex portIndex, QVariant const &value, PortRole role)
 {
@@ -369,11 +688,15 @@ bool DataFlowGraphModel::setPortData(
 
     QVariant result;
 
-    auto it = _models.find(nodeId);
-    if (it == _models.end())
+    NodeEntry *entry = nodeEntry(nodeId);
+    if (entry == nullptr)
         return false;
 
-    auto &model = it->second;
+    // A mapped node pulls its inputs when it is loaded.
+    if (entry->mapped)
+        return false;
+
+    NodeDelegateModel *model = entry->model.get();
 
     switch (role) {
     case PortRole::Data:
@@ -402,6 +725,8 @@ bool DataFlowGraphModel::deleteConnection(ConnectionId const connectionId)
         disconnected = true;
 
         _connectivity.erase(it);
+
+        unindexConnection(connectionId);
     }
 
     if (disconnected) {
@@ -422,21 +747,32 @@ bool DataFlowGraphModel::deleteNode(NodeId const nodeId)
         deleteConnection(cId);
     }
 
-    _nodeGeometryData.erase(nodeId);
-    _models.erase(nodeId);
+    NodeEntry *entry = nodeEntry(nodeId);
+    if (entry != nullptr) {
+        if (entry->mapped && --_mappedScene->pendingNodes == 0)
+            _mappedScene.reset();
 
-    Q_EMIT nodeDeleted(nodeId);
+        eraseNode(nodeId);
+    }
+
+    notifyNodeDeleted(nodeId);
 
     return true;
 }
 
 QJsonObject DataFlowGraphModel::saveNode(NodeId const nodeId) const
 {
+    NodeEntry const *entry = nodeEntry(nodeId);
+
+    // Like the `std::unordered_map::at()` lookup this used to be.
+    if (entry == nullptr)
+        throw std::out_of_range("No node with id " + std::to_string(nodeId));
+
     QJsonObject nodeJson;
 
     nodeJson["id"] = static_cast<qint64>(nodeId);
 
-    nodeJson["internal-data"] = _models.at(nodeId)->save();
+    nodeJson["internal-data"] = internalData(*entry);
 
     {
         QPointF const pos = nodeData(nodeId, NodeRole::Position).value<QPointF>();
@@ -455,7 +791,7 @@ QJsonObject DataFlowGraphModel::save() const
     QJsonObject sceneJson;
 
     QJsonArray nodesJsonArray;
-    for (auto const nodeId : allNodeIds()) {
+    for (NodeId const nodeId : _nodeIds) {
         nodesJsonArray.append(saveNode(nodeId));
     }
     sceneJson["nodes"] = nodesJsonArray;
@@ -480,39 +816,128 @@ void DataFlowGraphModel::loadNode(QJsonObject const &nodeJson)
     // because all the new ids were created past the removed nodes.
     NodeId restoredNodeId = nodeJson["id"].toInt();
 
-    _nextNodeId = std::max(_nextNodeId, restoredNodeId + 1);
+    QJsonObject posJson = nodeJson["position"].toObject();
+    QPointF const pos(posJson["x"].toDouble(), posJson["y"].toDouble());
 
-    QJsonObject const internalDataJson = nodeJson["internal-data"].toObject();
+    restoreNode(restoredNodeId, pos, nodeJson["internal-data"].toObject());
+}
 
-    QString delegateModelName = internalDataJson["model-name"].toString();
+void DataFlowGraphModel::loadNodesConcurrently(std::vector<QByteArray> const &nodeElements)
+{
+    std::vector<DecodedNode> decoded(nodeElements.size());
 
-    std::unique_ptr<NodeDelegateModel> model = _registry->create(delegateModelName);
+    auto const &creators = _registry->registeredModelCreators();
 
-    if (model) {
-        connect(model.get(),
-                &NodeDelegateModel::dataUpdated,
-                [restoredNodeId, this](PortIndex const portIndex) {
-                    onOutPortDataUpdated(restoredNodeId, portIndex);
-                });
+    // Several elements per task keep the scheduling cost below the parsing.
+    std::size_t const elementsPerTask = 32;
 
-        _models[restoredNodeId] = std::move(model);
+    GraphEvaluationScheduler scheduler(threadPool());
 
-        Q_EMIT nodeCreated(restoredNodeId);
+    for (std::size_t first = 0; first < nodeElements.size(); first += elementsPerTask) {
+        std::size_t const last = std::min(first + elementsPerTask, nodeElements.size());
 
-        QJsonObject posJson = nodeJson["position"].toObject();
-        QPointF const pos(posJson["x"].toDouble(), posJson["y"].toDouble());
+        scheduler.addTask(
+            [&nodeElements, &creators, &decoded, first, last]() {
+                for (std::size_t i = first; i < last; ++i) {
+                    decodeNode(nodeElements[i], creators, decoded[i]);
+                }
+            },
+            false);
+    }
 
-        setNodeData(restoredNodeId, NodeRole::Position, pos);
+    scheduler.run();
 
-        _models[restoredNodeId]->load(internalDataJson);
-    } else {
+    // Models are QObjects and belong to the thread of the graph model.
+    GraphBatchUpdate const batch(*this);
+
+    for (auto const &node : decoded) {
+        NodeDelegateModel *restoredModel = insertRestoredNode(node.id,
+                                                              node.position,
+                                                              (*node.creator)());
+
+        restoredModel->load(node.internalData);
+    }
+}
+
+void DataFlowGraphModel::decodeNode(
+    QByteArray const &nodeElement,
+    NodeDelegateModelRegistry::RegisteredModelCreatorsMap const &creators,
+    DecodedNode &decoded)
+{
+    QJsonParseError error;
+    QJsonObject const nodeJson = QJsonDocument::fromJson(nodeElement, &error).object();
+
+    if (error.error != QJsonParseError::NoError) {
+        throw std::runtime_error(std::string("Malformed node element at offset ")
+                                 + std::to_string(error.offset) + ": "
+                                 + error.errorString().toStdString());
+    }
+
+    decoded.id = nodeJson["id"].toInt();
+
+    QJsonObject posJson = nodeJson["position"].toObject();
+    decoded.position = QPointF(posJson["x"].toDouble(), posJson["y"].toDouble());
+
+    decoded.internalData = nodeJson["internal-data"].toObject();
+
+    QString const delegateModelName = decoded.internalData["model-name"].toString();
+
+    auto it = creators.find(delegateModelName);
+
+    if (it == creators.end()) {
         throw std::logic_error(std::string("No registered model with name ")
                                + delegateModelName.toLocal8Bit().data());
     }
+
+    decoded.creator = &it->second;
+}
+
+void DataFlowGraphModel::restoreNode(NodeId const restoredNodeId,
+                                     QPointF const &pos,
+                                     QJsonObject const &internalDataJson)
+{
+    NodeDelegateModel *restoredModel
+        = createRestoredNode(restoredNodeId, pos, internalDataJson["model-name"].toString());
+
+    restoredModel->load(internalDataJson);
+}
+
+NodeDelegateModel *DataFlowGraphModel::createRestoredNode(NodeId const restoredNodeId,
+                                                          QPointF const &pos,
+                                                          QString const &delegateModelName)
+{
+    std::unique_ptr<NodeDelegateModel> model = _registry->create(delegateModelName);
+
+    if (model)
+        return insertRestoredNode(restoredNodeId, pos, std::move(model));
+
+    throw std::logic_error(std::string("No registered model with name ")
+                           + delegateModelName.toLocal8Bit().data());
+}
+
+NodeDelegateModel *DataFlowGraphModel::insertRestoredNode(NodeId const restoredNodeId,
+                                                          QPointF const &pos,
+                                                          std::unique_ptr<NodeDelegateModel> model)
+{
+    connectNodeModel(restoredNodeId, model.get());
+
+    NodeDelegateModel *restoredModel = model.get();
+
+    insertNode(restoredNodeId, std::move(model));
+
+    _nextNodeId = std::max(_nextNodeId, restoredNodeId + 1);
+
+    notifyNodeCreated(restoredNodeId);
+
+    setNodeData(restoredNodeId, NodeRole::Position, pos);
+
+    return restoredModel;
 }
 
 void DataFlowGraphModel::load(QJsonObject const &jsonDocument)
 {
+    GraphBatchUpdate const batch(*this);
+
     QJsonArray nodesJsonArray = jsonDocument["nodes"].toArray();
 
     for (QJsonValueRef nodeJson : nodesJsonArray) {
@@ -531,11 +956,499 @@ void DataFlowGraphModel::load(QJsonObject const &jsonDocument)
     }
 }
 
+QByteArray DataFlowGraphModel::saveBinary() const
+{
+    BinarySceneWriter writer;
+
+    for (NodeId const nodeId : _nodeIds) {
+        NodeEntry const &entry = *nodeEntry(nodeId);
+        writer.addNode(nodeId, entry.geometry.pos, internalData(entry));
+    }
+
+    for (auto const &cid : _connectivity) {
+        writer.addConnection(cid);
+    }
+
+    return writer.data();
+}
+
+void DataFlowGraphModel::loadBinary(QByteArray const &data)
+{
+    BinarySceneReader const reader(data);
+
+    if (!reader.isValid())
+        throw std::runtime_error(reader.errorString().toStdString());
+
+    // Parsed up front so that corrupted node data does not leave the scene half loaded.
+    std::vector<QJsonObject> internalData;
+    internalData.reserve(reader.nodeCount());
+
+    for (std::size_t i = 0; i < reader.nodeCount(); ++i) {
+        QString errorString;
+        internalData.push_back(reader.nodeInternalData(i, &errorString));
+
+        if (!errorString.isEmpty())
+            throw std::runtime_error(errorString.toStdString());
+    }
+
+    GraphBatchUpdate const batch(*this);
+
+    for (std::size_t i = 0; i < reader.nodeCount(); ++i) {
+        restoreNode(reader.nodeId(i), reader.nodePosition(i), internalData[i]);
+    }
+
+    for (std::size_t i = 0; i < reader.connectionCount(); ++i) {
+        addConnection(reader.connection(i));
+    }
+}
+
+void DataFlowGraphModel::loadMapped(QString const &fileName)
+{
+    // Only one file is mapped at a time.
+    materializeAll();
+
+    auto mapped = std::make_unique<MappedScene>();
+
+    mapped->file.setFileName(fileName);
+    if (!mapped->file.open(QIODevice::ReadOnly))
+        throw std::runtime_error(mapped->file.errorString().toStdString());
+
+    qint64 const size = mapped->file.size();
+
+    uchar const *data = mapped->file.map(0, size);
+    if (data == nullptr)
+        throw std::runtime_error(mapped->file.errorString().toStdString());
+
+    mapped->reader = std::make_unique<BinarySceneReader>(reinterpret_cast<char const *>(data),
+                                                         static_cast<std::size_t>(size));
+
+    if (!mapped->reader->isValid())
+        throw std::runtime_error(mapped->reader->errorString().toStdString());
+
+    _mappedScene = std::move(mapped);
+
+    BinarySceneReader const &reader = *_mappedScene->reader;
+
+    GraphBatchUpdate const batch(*this);
+
+    for (std::size_t i = 0; i < reader.nodeCount(); ++i) {
+        NodeId const nodeId = reader.nodeId(i);
+
+        createRestoredNode(nodeId, reader.nodePosition(i), reader.nodeModelName(i));
+
+        NodeEntry &entry = *nodeEntry(nodeId);
+        entry.mapped = true;
+        entry.mappedRecord = i;
+
+        ++_mappedScene->pendingNodes;
+    }
+
+    // Nothing is propagated, the nodes pull their inputs when loaded.
+    for (std::size_t i = 0; i < reader.connectionCount(); ++i) {
+        ConnectionId const connectionId = reader.connection(i);
+
+        if (!connectionValid(connectionId))
+            continue;
+
+        if (_connectivity.insert(connectionId).second)
+            indexConnection(connectionId);
+
+        sendConnectionCreation(connectionId);
+    }
+
+    if (_mappedScene->pendingNodes == 0)
+        _mappedScene.reset();
+}
+
+std::size_t DataFlowGraphModel::mappedNodeCount() const
+{
+    return _mappedScene ? _mappedScene->pendingNodes : 0u;
+}
+
+void DataFlowGraphModel::materializeMapped(NodeEntry const &entry) const
+{
+    NodeId const nodeId = _nodeIds[entry.denseIndex];
+    NodeDelegateModel *model = entry.model.get();
+
+    QString errorString;
+    QJsonObject const internalDataJson = _mappedScene->reader->nodeInternalData(entry.mappedRecord,
+                                                                                &errorString);
+
+    // Nodes are loaded lazily inside queries, the model keeps its defaults.
+    if (!errorString.isEmpty())
+        qWarning() << "Failed to load mapped node" << nodeId << ":" << errorString;
+
+    // Cleared first so that cycles and re-entrant queries see a loaded node.
+    entry.mapped = false;
+
+    if (--_mappedScene->pendingNodes == 0)
+        _mappedScene.reset();
+
+    model->load(internalDataJson);
+
+    if (NodeEntry const *loaded = nodeEntry(nodeId))
+        loaded->portInfoValid = false;
+
+    // Materializing happens inside const queries, the inputs are delivered
+    // from the event loop through the usual propagation instead.
+    auto *self = const_cast<DataFlowGraphModel *>(this);
+    QMetaObject::invokeMethod(
+        self, [self, nodeId]() { self->restoreInputs(nodeId); }, Qt::QueuedConnection);
+}
+
+void DataFlowGraphModel::restoreInputs(NodeId const nodeId)
+{
+    NodeEntry const *entry = nodeEntry(nodeId);
+    if (entry == nullptr)
+        return;
+
+    std::vector<ConnectionId> inputs;
+    for (auto const &attached : entry->connections.in) {
+        inputs.insert(inputs.end(), attached.begin(), attached.end());
+    }
+
+    // The same inputs `addConnection()` would have delivered at load time.
+    for (auto const &cn : inputs) {
+        if (!connectionExists(cn))
+            continue;
+
+        setPortData(cn.inNodeId,
+                    PortType::In,
+                    cn.inPortIndex,
+                    portData(cn.outNodeId, PortType::Out, cn.outPortIndex, PortRole::Data),
+                    PortRole::Data);
+    }
+}
+
+void DataFlowGraphModel::materializeAll()
+{
+    for (std::size_t i = 0; _mappedScene && i < _nodeIds.size(); ++i) {
+        materialize(*nodeEntry(_nodeIds[i]));
+    }
+}
+
+QJsonObject DataFlowGraphModel::internalData(NodeEntry const &entry) const
+{
+    if (entry.mapped)
+        return _mappedScene->reader->nodeInternalData(entry.mappedRecord);
+
+    return entry.model->save();
+}
+
+void DataFlowGraphModel::setPropagationMode(PropagationMode mode)
+{
+    if (_propagationMode == mode)
+        return;
+
+    _propagationMode = mode;
+
+    if (_propagationMode == PropagationMode::Immediate)
+        flushPropagation();
+}
+
+unsigned int DataFlowGraphModel::threadCount() const
+{
+    if (_threadPool)
+        return _threadPool->threadCount();
+
+    if (_threadCount != 0)
+        return _threadCount;
+
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void DataFlowGraphModel::setThreadCount(unsigned int threadCount)
+{
+    if (_threadCount == threadCount)
+        return;
+
+    _threadCount = threadCount;
+    _threadPool.reset();
+}
+
+WorkStealingThreadPool &DataFlowGraphModel::threadPool()
+{
+    if (!_threadPool)
+        _threadPool = std::make_unique<WorkStealingThreadPool>(_threadCount);
+
+    return *_threadPool;
+}
+
+void DataFlowGraphModel::flushPropagation()
+{
+    _propagationScheduled = false;
+
+    if (_propagating || _dirtyOutputs.empty())
+        return;
+
+    _propagating = true;
+
+    std::unordered_set<NodeId> settled;
+    for (auto const &dirty : _dirtyOutputs) {
+        settled.insert(dirty.first);
+    }
+
+    std::size_t acyclicCount = 0;
+    std::vector<NodeId> const order = propagationOrder(&acyclicCount);
+
+    settled.insert(order.begin(), order.end());
+
+    if (_propagationMode == PropagationMode::Parallel) {
+        evaluateInParallel(order, acyclicCount);
+    } else {
+        for (NodeId const nodeId : order) {
+            evaluateNode(nodeId);
+        }
+    }
+
+    std::vector<std::pair<NodeId, PortIndex>> updatedInputs;
+    updatedInputs.swap(_updatedInputs);
+
+    // Updates coming from the evaluated nodes are consumed. Back edges of
+    // cycles are dropped here as well, otherwise the tick would never end.
+    for (auto it = _dirtyOutputs.begin(); it != _dirtyOutputs.end();) {
+        if (settled.count(it->first) > 0)
+            it = _dirtyOutputs.erase(it);
+        else
+            ++it;
+    }
+
+    _propagating = false;
+
+    // Triggers repainting on the scene.
+    for (auto const &input : updatedInputs) {
+        Q_EMIT inPortDataWasSet(input.first, PortType::In, input.second);
+    }
+
+    if (!_dirtyOutputs.empty())
+        schedulePropagation();
+}
+
+void DataFlowGraphModel::evaluateNode(NodeId const nodeId)
+{
+    // The node could be deleted by one of the upstream models.
+    NodeEntry const *entry = nodeEntry(nodeId);
+    if (entry == nullptr || entry->mapped)
+        return;
+
+    NodeDelegateModel *model = entry->model.get();
+
+    std::vector<ConnectionId> updated;
+    {
+        std::lock_guard<std::mutex> lock(_propagationMutex);
+
+        for (auto const &attached : entry->connections.in) {
+            for (auto const &cn : attached) {
+                if (_dirtyOutputs.count(std::make_pair(cn.outNodeId, cn.outPortIndex)) > 0)
+                    updated.push_back(cn);
+            }
+        }
+    }
+
+    if (updated.empty())
+        return;
+
+    std::vector<std::pair<PortIndex, std::shared_ptr<NodeData>>> inputs;
+    inputs.reserve(updated.size());
+
+    for (auto const &cn : updated) {
+        NodeEntry const *upstream = nodeEntry(cn.outNodeId);
+        inputs.emplace_back(cn.inPortIndex, upstream->model->outData(cn.outPortIndex));
+    }
+
+    // Outputs updated by the node are recorded in `_dirtyOutputs` and picked
+    // up by the nodes further in the order.
+    DataFlowGraphModel const *const previous = evaluatingModel;
+    evaluatingModel = this;
+
+    model->setInDataBatch(inputs);
+
+    evaluatingModel = previous;
+
+    std::lock_guard<std::mutex> lock(_propagationMutex);
+
+    PortIndex lastPortIndex = InvalidPortIndex;
+    for (auto const &input : inputs) {
+        if (input.first != lastPortIndex) {
+            lastPortIndex = input.first;
+            _updatedInputs.emplace_back(nodeId, lastPortIndex);
+        }
+    }
+}
+
+void DataFlowGraphModel::evaluateInParallel(std::vector<NodeId> const &order,
+                                            std::size_t const acyclicCount)
+{
+    GraphEvaluationScheduler scheduler(threadPool());
+
+    std::unordered_map<NodeId, std::size_t> taskIndex;
+    taskIndex.reserve(acyclicCount);
+
+    for (std::size_t i = 0; i < acyclicCount; ++i) {
+        NodeId const nodeId = order[i];
+        NodeEntry const *entry = nodeEntry(nodeId);
+
+        // The task reads `outData()` of the upstream models, which must be
+        // safe to call from a worker as well.
+        bool mainThreadOnly = !entry->model->threadSafe();
+
+        for (auto const &attached : entry->connections.in) {
+            for (auto const &cn : attached) {
+                NodeEntry const *upstream = nodeEntry(cn.outNodeId);
+
+                if (upstream && !upstream->model->threadSafe())
+                    mainThreadOnly = true;
+            }
+        }
+
+        taskIndex[nodeId] = scheduler.addTask([this, nodeId]() { evaluateNode(nodeId); },
+                                              mainThreadOnly);
+    }
+
+    for (std::size_t i = 0; i < acyclicCount; ++i) {
+        NodeId const nodeId = order[i];
+
+        visitAllConnections(nodeId, [&](ConnectionId const &cn) {
+            if (cn.outNodeId != nodeId)
+                return;
+
+            auto it = taskIndex.find(cn.inNodeId);
+            if (it != taskIndex.end())
+                scheduler.addDependency(taskIndex[nodeId], it->second);
+        });
+    }
+
+    scheduler.run();
+
+    // Nodes in cycles have no valid order, evaluate them one by one.
+    for (std::size_t i = acyclicCount; i < order.size(); ++i) {
+        evaluateNode(order[i]);
+    }
+}
+
+void DataFlowGraphModel::schedulePropagation()
+{
+    if (_propagating || _propagationScheduled)
+        return;
+
+    _propagationScheduled = true;
+
+    QTimer::singleShot(0, this, [this]() { flushPropagation(); });
+}
+
+std::vector<NodeId> DataFlowGraphModel::propagationOrder(std::size_t *acyclicCount) const
+{
+    std::unordered_set<NodeId> affected;
+    std::vector<NodeId> pending;
+
+    auto collectDownstream = [&](NodeId const nodeId, PortIndex const portIndex) {
+        if (auto const *attached = portConnections(nodeId, PortType::Out, portIndex)) {
+            for (auto const &cn : *attached) {
+                if (affected.insert(cn.inNodeId).second)
+                    pending.push_back(cn.inNodeId);
+            }
+        }
+    };
+
+    for (auto const &dirty : _dirtyOutputs) {
+        collectDownstream(dirty.first, dirty.second);
+    }
+
+    while (!pending.empty()) {
+        NodeId const nodeId = pending.back();
+        pending.pop_back();
+
+        NodeEntry const *entry = nodeEntry(nodeId);
+        if (entry == nullptr)
+            continue;
+
+        for (PortIndex portIndex = 0; portIndex < entry->connections.out.size(); ++portIndex) {
+            collectDownstream(nodeId, portIndex);
+        }
+    }
+
+    // Kahn's algorithm over the affected subgraph.
+    std::unordered_map<NodeId, unsigned int> inDegree;
+    inDegree.reserve(affected.size());
+
+    for (NodeId const nodeId : affected) {
+        unsigned int &degree = inDegree[nodeId];
+
+        visitAllConnections(nodeId, [&](ConnectionId const &cn) {
+            if (cn.inNodeId == nodeId && affected.count(cn.outNodeId) > 0)
+                ++degree;
+        });
+    }
+
+    std::vector<NodeId> order;
+    order.reserve(affected.size());
+
+    for (auto const &p : inDegree) {
+        if (p.second == 0)
+            order.push_back(p.first);
+    }
+
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        NodeId const nodeId = order[i];
+
+        visitAllConnections(nodeId, [&](ConnectionId const &cn) {
+            if (cn.outNodeId != nodeId)
+                return;
+
+            auto degreeIt = inDegree.find(cn.inNodeId);
+            if (degreeIt != inDegree.end() && --degreeIt->second == 0)
+                order.push_back(cn.inNodeId);
+        });
+    }
+
+    if (acyclicCount)
+        *acyclicCount = order.size();
+
+    // Cycles never reach the zero in-degree, evaluate them last.
+    for (auto const &p : inDegree) {
+        if (p.second > 0)
+            order.push_back(p.first);
+    }
+
+    return order;
+}
+
 void DataFlowGraphModel::onOutPortDataUpdated(NodeId const nodeId, PortIndex const portIndex)
 {
-    std::unordered_set<ConnectionId> const &connected = connections(nodeId,
-                                                                    PortType::Out,
-                                                                    portIndex);
+    if (evaluatingModel != this && QThread::currentThread() != thread()) {
+        // Models updating their outputs from their own threads are served on
+        // the thread owning the graph.
+        QMetaObject::invokeMethod(
+            this,
+            [this, nodeId, portIndex]() { onOutPortDataUpdated(nodeId, portIndex); },
+            Qt::QueuedConnection);
+        return;
+    }
+
+    if (QThread::currentThread() == thread())
+        Q_EMIT outPortDataUpdated(nodeId, portIndex);
+
+    if (_propagationMode != PropagationMode::Immediate) {
+        {
+            std::lock_guard<std::mutex> lock(_propagationMutex);
+            _dirtyOutputs.insert(std::make_pair(nodeId, portIndex));
+        }
+
+        // Updates emitted during a tick are handled by the tick itself.
+        if (evaluatingModel != this)
+            schedulePropagation();
+
+        return;
+    }
+
+    auto const *attached = portConnections(nodeId, PortType::Out, portIndex);
+
+    if (attached == nullptr)
+        return;
+
+    // Receiving nodes are free to modify the graph in `setInData`, so the
+    // index entry can't be iterated directly.
+    std::vector<ConnectionId> const connected = *attached;
 
     QVariant const portDataToPropagate = portData(nodeId, PortType::Out, portIndex, PortRole::Data);
 
@@ -1,9 +1,11 @@
 #include "DataFlowGraphicsScene.hpp"
 
+#include "BinarySceneFormat.hpp"
 #include "ConnectionGraphicsObject.hpp"
 #include "GraphicsView.hpp"
 #include "NodeDelegateModelRegistry.hpp"
 #include "NodeGraphicsObject.hpp"
+#include "StreamingSceneLoader.hpp"
 #include "UndoCommands.hpp"
 
 #include <QtWidgets/QFileDialog>
@@ -149,15 +151,21 @@ bool DataFlowGraphicsScene::save() const
     QString fileName = QFileDialog::getSaveFileName(nullptr,
                                                     tr("Open Flow Scene"),
                                                     QDir::homePath(),
-                                                    tr("Flow Scene Files (*.flow)"));
+                                                    tr("Flow Scene Files (*.flow);;"
+                                                       "Binary Flow Scene Files (*.flowb)"));
 
     if (!fileName.isEmpty()) {
-        if (!fileName.endsWith("flow", Qt::CaseInsensitive))
+        bool const binary = fileName.endsWith(".flowb", Qt::CaseInsensitive);
+
+        if (!binary && !fileName.endsWith("flow", Qt::CaseInsensitive))
             fileName += ".flow";
 
         QFile file(fileName);
         if (file.open(QIODevice::WriteOnly)) {
-            file.write(QJsonDocument(_graphModel.save()).toJson());
+            if (binary)
+                file.write(_graphModel.saveBinary());
+            else
+                file.write(QJsonDocument(_graphModel.save()).toJson());
             return true;
         }
     }
@@ -169,7 +177,7 @@ bool DataFlowGraphicsScene::load()
     QString fileName = QFileDialog::getOpenFileName(nullptr,
                                                     tr("Open Flow Scene"),
                                                     QDir::homePath(),
-                                                    tr("Flow Scene Files (*.flow)"));
+                                                    tr("Flow Scene Files (*.flow *.flowb)"));
 
     if (!QFileInfo::exists(fileName))
         return false;
@@ -181,9 +189,25 @@ bool DataFlowGraphicsScene::load()
 
     clearScene();
 
-    QByteArray const wholeFile = file.readAll();
+    try {
+        if (BinarySceneFormat::isBinaryScene(file.peek(sizeof(BinarySceneFormat::Magic)))) {
+            // The node items query every node, lazy loading would not pay off.
+            _graphModel.loadBinary(file.readAll());
+        } else {
+            StreamingSceneLoader loader(_graphModel);
+
+            if (!loader.load(file))
+                throw std::runtime_error(loader.errorString().toStdString());
+        }
+    } catch (std::exception const &e) {
+        // A half-loaded scene is not kept, the error goes to the caller.
+        clearScene();
 
-    _graphModel.load(QJsonDocument::fromJson(wholeFile).object());
+        QString const message = QStringLiteral("Failed to load %1: %2")
+                                    .arg(fileName, QString::fromLocal8Bit(e.what()));
+
+        throw std::runtime_error(message.toStdString());
+    }
 
     Q_EMIT sceneLoaded();
 
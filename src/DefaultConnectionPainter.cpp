@@ -2,7 +2,10 @@
 
 #include <QtGui/QIcon>
 
+#include <algorithm>
+
 #include "AbstractGraphModel.hpp"
+#include "BasicGraphicsScene.hpp"
 #include "ConnectionGraphicsObject.hpp"
 #include "ConnectionState.hpp"
 #include "Definitions.hpp"
@@ -13,17 +16,7 @@ namespace QtNodes {
 
 QPainterPath DefaultConnectionPainter::cubicPath(ConnectionGraphicsObject const &connection) const
 {
-    QPointF const &in = connection.endPoint(PortType::In);
-    QPointF const &out = connection.endPoint(PortType::Out);
-
-    auto const c1c2 = connection.pointsC1C2();
-
-    // cubic spline
-    QPainterPath cubic(out);
-
-    cubic.cubicTo(c1c2.first, c1c2.second, in);
-
-    return cubic;
+    return connection.cubicPath();
 }
 
 void DefaultConnectionPainter::drawSketchLine(QPainter *painter, ConnectionGraphicsObject const &cgo, QPainterPath const &cubic) const
@@ -97,21 +90,16 @@ void DefaultConnectionPainter::drawNormalLine(QPainter *painter, ConnectionGraph
 
         auto const cId = cgo.connectionId();
 
-        auto dataTypeOut = graphModel
-                               .portData(cId.outNodeId,
-                                         PortType::Out,
-                                         cId.outPortIndex,
-                                         PortRole::DataType)
-                               .value<NodeDataType>();
+        PortInfo const infoOut = graphModel.portInfo(cId.outNodeId,
+                                                     PortType::Out,
+                                                     cId.outPortIndex);
 
-        auto dataTypeIn
-            = graphModel.portData(cId.inNodeId, PortType::In, cId.inPortIndex, PortRole::DataType)
-                  .value<NodeDataType>();
+        PortInfo const infoIn = graphModel.portInfo(cId.inNodeId, PortType::In, cId.inPortIndex);
 
-        useGradientColor = (dataTypeOut.id != dataTypeIn.id);
+        useGradientColor = infoOut.typeHandle != infoIn.typeHandle;
 
-        normalColorOut = connectionStyle.normalColor(dataTypeOut.id);
-        normalColorIn = connectionStyle.normalColor(dataTypeIn.id);
+        normalColorOut = connectionStyle.normalColor(infoOut.dataType.id, infoOut.typeHandle);
+        normalColorIn = connectionStyle.normalColor(infoIn.dataType.id, infoIn.typeHandle);
         selectedColor = normalColorOut.darker(200);
     }
 
@@ -136,17 +124,12 @@ void DefaultConnectionPainter::drawNormalLine(QPainter *painter, ConnectionGraph
         //             cIn = cIn.darker(200);
         // p.setColor(cOut);
         // painter->setPen(p);
-        if (selected) {
-            cOut = cOut.darker(200);
-            cIn = cIn.darker(200);
-        }
 
         // unsigned int constexpr segments = 60;
 
-        QLinearGradient linear(cubic.pointAtPercent(0.0),cubic.pointAtPercent(1.0));
-        linear.setColorAt(1, cIn);
-        // linear.setColorAt(0.5, Qt::black);
-        linear.setColorAt(0, cOut);
+        QLinearGradient linear = conversionGradient(cOut, cIn, selected);
+        linear.setStart(cubic.pointAtPercent(0.0));
+        linear.setFinalStop(cubic.pointAtPercent(1.0));
         p.setBrush(linear);
         // painter->setBrush(linear);
         painter->setPen(p);
@@ -167,10 +150,7 @@ void DefaultConnectionPainter::drawNormalLine(QPainter *painter, ConnectionGraph
         // }
 
         {
-            QIcon icon(":convert.png");
-
-
-            QPixmap pixmap = icon.pixmap(QSize(10, 10));
+            QPixmap const &pixmap = conversionPixmap(painter->device()->devicePixelRatioF());
             painter->drawPixmap(cubic.pointAtPercent(0.50)
                                     - QPoint(5,5),
                                 pixmap);
@@ -189,8 +169,28 @@ void DefaultConnectionPainter::drawNormalLine(QPainter *painter, ConnectionGraph
     }
 }
 
+void DefaultConnectionPainter::drawStraightLine(QPainter *painter,
+                                                ConnectionGraphicsObject const &cgo) const
+{
+    auto const &connectionStyle = QtNodes::StyleCollection::connectionStyle();
+
+    painter->setPen(QPen(cgo.isSelected() ? connectionStyle.selectedColor()
+                                          : connectionStyle.normalColor(),
+                         connectionStyle.lineWidth()));
+
+    painter->drawLine(cgo.out(), cgo.in());
+}
+
 void DefaultConnectionPainter::paint(QPainter *painter, ConnectionGraphicsObject const &cgo) const
 {
+    LevelOfDetail const detail = cgo.nodeScene()->levelOfDetail(painter->worldTransform());
+
+    // Connections being drawn keep their dashed curve.
+    if (detail == LevelOfDetail::Minimal && !cgo.connectionState().requiresPort()) {
+        drawStraightLine(painter, cgo);
+        return;
+    }
+
     auto cubic = cubicPath(cgo);
     drawHoveredOrSelected(painter, cgo,cubic);
 
@@ -202,6 +202,9 @@ void DefaultConnectionPainter::paint(QPainter *painter, ConnectionGraphicsObject
     debugDrawing(painter, cgo,cubic);
 #endif
 
+    if (detail != LevelOfDetail::Full)
+        return;
+
     // draw end points
     auto const &connectionStyle = QtNodes::StyleCollection::connectionStyle();
 
@@ -224,6 +227,179 @@ void DefaultConnectionPainter::paint(QPainter *painter, ConnectionGraphicsObject
     }
 }
 
+bool DefaultConnectionPainter::batchable(ConnectionGraphicsObject const &cgo) const
+{
+    if (cgo.connectionState().requiresPort())
+        return false;
+
+    auto const &connectionStyle = QtNodes::StyleCollection::connectionStyle();
+
+    if (!connectionStyle.useDataDefinedColors())
+        return true;
+
+    // Different data types are joined by a gradient with a marker.
+    AbstractGraphModel const &graphModel = cgo.graphModel();
+
+    auto const cId = cgo.connectionId();
+
+    PortInfo const infoOut = graphModel.portInfo(cId.outNodeId, PortType::Out, cId.outPortIndex);
+
+    PortInfo const infoIn = graphModel.portInfo(cId.inNodeId, PortType::In, cId.inPortIndex);
+
+    return infoOut.typeHandle == infoIn.typeHandle;
+}
+
+void DefaultConnectionPainter::paintBatch(
+    QPainter *painter, std::vector<ConnectionGraphicsObject const *> const &connections) const
+{
+    if (connections.empty())
+        return;
+
+    auto const &connectionStyle = QtNodes::StyleCollection::connectionStyle();
+
+    LevelOfDetail const detail = connections.front()->nodeScene()->levelOfDetail(
+        painter->worldTransform());
+
+    // Like `drawStraightLine()`, the minimal detail ignores the data types.
+    bool const useDataDefinedColors = connectionStyle.useDataDefinedColors()
+                                      && detail != LevelOfDetail::Minimal;
+
+    QRgb const normalColor = connectionStyle.normalColor().rgba();
+
+    double const pointDiameter = connectionStyle.pointDiameter();
+    double const pointRadius = pointDiameter / 2.0;
+
+    // Few colors are in use, a linear search beats hashing.
+    std::vector<std::pair<QRgb, QPainterPath>> lines;
+
+    QPainterPath points;
+    points.setFillRule(Qt::WindingFill);
+
+    for (ConnectionGraphicsObject const *cgo : connections) {
+        QRgb color = normalColor;
+
+        if (useDataDefinedColors) {
+            auto const cId = cgo->connectionId();
+
+            AbstractGraphModel const &graphModel = cgo->graphModel();
+
+            PortInfo const info = graphModel.portInfo(cId.outNodeId,
+                                                      PortType::Out,
+                                                      cId.outPortIndex);
+
+            color = connectionStyle.normalColor(info.dataType.id, info.typeHandle).rgba();
+        }
+
+        auto line = std::find_if(lines.begin(), lines.end(), [color](auto const &l) {
+            return l.first == color;
+        });
+
+        if (line == lines.end())
+            line = lines.emplace(lines.end(), color, QPainterPath());
+
+        QPainterPath &path = line->second;
+
+        QPointF const offset = cgo->pos();
+
+        path.moveTo(cgo->out() + offset);
+
+        if (detail == LevelOfDetail::Minimal) {
+            path.lineTo(cgo->in() + offset);
+            continue;
+        }
+
+        auto const c1c2 = cgo->pointsC1C2();
+
+        path.cubicTo(c1c2.first + offset, c1c2.second + offset, cgo->in() + offset);
+
+        if (detail != LevelOfDetail::Full)
+            continue;
+
+        QPainterPath const &cubic = cgo->cubicPath();
+
+        if (connectionStyle.outArrow()) {
+            points.addPolygon(
+                createArrowPoly(cubic, pointRadius, pointDiameter * 1.5, false).translated(offset));
+            points.closeSubpath();
+        } else {
+            points.addEllipse(cgo->out() + offset, pointRadius, pointRadius);
+        }
+
+        if (connectionStyle.inArrow()) {
+            points.addPolygon(
+                createArrowPoly(cubic, pointRadius, pointDiameter * 1.5, true).translated(offset));
+            points.closeSubpath();
+        } else {
+            points.addEllipse(cgo->in() + offset, pointRadius, pointRadius);
+        }
+    }
+
+    painter->setBrush(Qt::NoBrush);
+
+    for (auto const &line : lines) {
+        QPen p;
+
+        if (detail == LevelOfDetail::Minimal)
+            p.setWidthF(connectionStyle.lineWidth());
+        else
+            p.setWidth(connectionStyle.lineWidth());
+
+        p.setColor(QColor::fromRgba(line.first));
+
+        painter->setPen(p);
+        painter->drawPath(line.second);
+    }
+
+    if (!points.isEmpty()) {
+        painter->setPen(connectionStyle.constructionColor());
+        painter->setBrush(connectionStyle.constructionColor());
+        painter->drawPath(points);
+    }
+}
+
+QPixmap const &DefaultConnectionPainter::conversionPixmap(qreal devicePixelRatio) const
+{
+    for (auto const &entry : _conversionPixmaps) {
+        if (entry.first == devicePixelRatio)
+            return entry.second;
+    }
+
+    if (_conversionIcon.isNull())
+        _conversionIcon = QIcon(":convert.png");
+
+    // Rendered at the device resolution but laid out as at most 10x10, whether
+    // or not QIcon already applied the application's pixel ratio.
+    QPixmap pixmap = _conversionIcon.pixmap(QSize(10, 10) * devicePixelRatio);
+    pixmap.setDevicePixelRatio(std::max<qreal>(1.0, pixmap.width() / 10.0));
+
+    _conversionPixmaps.emplace_back(devicePixelRatio, pixmap);
+
+    return _conversionPixmaps.back().second;
+}
+
+QLinearGradient const &DefaultConnectionPainter::conversionGradient(QColor const &out,
+                                                                    QColor const &in,
+                                                                    bool selected) const
+{
+    auto const key = std::make_tuple(out.rgba(), in.rgba(), selected);
+
+    auto it = _conversionGradients.find(key);
+
+    if (it != _conversionGradients.end())
+        return it->second;
+
+    // Colors come from the data types, so this only guards against misuse.
+    if (_conversionGradients.size() >= 1024)
+        _conversionGradients.clear();
+
+    QLinearGradient linear;
+    linear.setColorAt(1, selected ? in.darker(200) : in);
+    // linear.setColorAt(0.5, Qt::black);
+    linear.setColorAt(0, selected ? out.darker(200) : out);
+
+    return _conversionGradients.emplace(key, linear).first->second;
+}
+
 QPainterPath DefaultConnectionPainter::getPainterStroke(ConnectionGraphicsObject const &connection) const
 {
     auto cubic = cubicPath(connection);
@@ -10,7 +10,7 @@
 namespace QtNodes {
 
 DefaultHorizontalNodeGeometry::DefaultHorizontalNodeGeometry(AbstractGraphModel &graphModel)
-    : AbstractNodeGeometry(graphModel)
+    : CachedNodeGeometry(graphModel)
     , _portSize(10)
     , _portSpasing(10)
     , _fontMetrics(QFont())
@@ -23,14 +23,13 @@ DefaultHorizontalNodeGeometry::DefaultHorizontalNodeGeometry(AbstractGraphModel
     _portSize = _fontMetrics.height();
 }
 
-QSize DefaultHorizontalNodeGeometry::size(NodeId const nodeId) const
+QSize DefaultHorizontalNodeGeometry::measuredSize(NodeId const nodeId,
+                                                  NodeGeometry const &geometry) const
 {
-    return _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
-}
+    unsigned int const maxNumOfEntries = std::max(geometry.ports[0].size(),
+                                                  geometry.ports[1].size());
 
-void DefaultHorizontalNodeGeometry::recomputeSize(NodeId const nodeId) const
-{
-    unsigned int height = maxVerticalPortsExtent(nodeId);
+    unsigned int height = (_portSize + _portSpasing) * maxNumOfEntries;
 
     bool isEmbeded = _graphModel.nodeData(nodeId, NodeRole::WidgetEmbeddable).value<bool>();
     auto w = _graphModel.nodeData<QWidget *>(nodeId, NodeRole::Widget);
@@ -39,15 +38,15 @@ void DefaultHorizontalNodeGeometry::recomputeSize(NodeId const nodeId) const
         height = std::max(height, static_cast<unsigned int>(w->height()));
     }
 
-    QRectF const capRect = captionRect(nodeId);
+    QRectF const &capRect = geometry.captionRect;
 
     height += capRect.height();
 
     height += _portSpasing; // space above caption
     height += _portSpasing; // space below caption
 
-    unsigned int inPortWidth = maxPortsTextAdvance(nodeId, PortType::In);
-    unsigned int outPortWidth = maxPortsTextAdvance(nodeId, PortType::Out);
+    unsigned int inPortWidth = geometry.portsTextAdvance[static_cast<int>(PortType::In)];
+    unsigned int outPortWidth = geometry.portsTextAdvance[static_cast<int>(PortType::Out)];
 
     unsigned int width = inPortWidth + outPortWidth + 4 * _portSpasing;
 
@@ -57,193 +56,118 @@ void DefaultHorizontalNodeGeometry::recomputeSize(NodeId const nodeId) const
 
     width = std::max(width, static_cast<unsigned int>(capRect.width()) + 2 * _portSpasing);
 
-    QSize size(width, height);
+    return QSize(width, height);
+}
+
+QRect DefaultHorizontalNodeGeometry::resizeHandleRect(NodeId const nodeId) const
+{
+    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+
+    unsigned int rectSize = 7;
 
-    _graphModel.setNodeData(nodeId, NodeRole::Size, size);
+    return QRect(size.width() - _portSpasing, size.height() - _portSpasing, rectSize, rectSize);
 }
 
-QPointF DefaultHorizontalNodeGeometry::portPosition(NodeId const nodeId,
-                                                    PortType const portType,
-                                                    PortIndex const portIndex) const
+void DefaultHorizontalNodeGeometry::measure(NodeId const nodeId, NodeGeometry &geometry) const
 {
-    unsigned int const step = _portSize + _portSpasing;
+    geometry.captionRect = QRectF();
 
-    QPointF result;
+    if (_graphModel.nodeData<bool>(nodeId, NodeRole::CaptionVisible)) {
+        geometry.captionRect = _boldFontMetrics.boundingRect(
+            _graphModel.nodeData<QString>(nodeId, NodeRole::Caption));
+    }
 
-    double totalHeight = 0.0;
+    for (PortType const portType : {PortType::In, PortType::Out}) {
+        size_t const n = _graphModel
+                             .nodeData(nodeId,
+                                       (portType == PortType::Out) ? NodeRole::OutPortCount
+                                                                   : NodeRole::InPortCount)
+                             .toUInt();
 
-    totalHeight += captionRect(nodeId).height();
-    totalHeight += _portSpasing;
+        auto &ports = geometry.ports[static_cast<int>(portType)];
 
-    totalHeight += step * portIndex;
-    totalHeight += step / 2.0;
+        ports.resize(n);
 
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+        unsigned int width = 0;
 
-    switch (portType) {
-    case PortType::In: {
-        double x = 0.0;
+        for (PortIndex portIndex = 0ul; portIndex < n; ++portIndex) {
+            QString name;
 
-        result = QPointF(x, totalHeight);
-        break;
-    }
+            PortInfo const info = _graphModel.portInfo(nodeId, portType, portIndex);
+            // PortRole::CaptionVisible 为false时不计算文本框宽度
+            if (info.captionVisible) {
+                name = info.caption;
+            }
 
-    case PortType::Out: {
-        double x = size.width();
+            ports[portIndex].textRect = _fontMetrics.boundingRect(name);
 
-        result = QPointF(x, totalHeight);
-        break;
-    }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+            width = std::max(unsigned(_fontMetrics.horizontalAdvance(name)), width);
+#else
+            width = std::max(unsigned(_fontMetrics.width(name)), width);
+#endif
+        }
 
-    default:
-        break;
+        geometry.portsTextAdvance[static_cast<int>(portType)] = width;
     }
-
-    return result;
 }
 
-QPointF DefaultHorizontalNodeGeometry::portTextPosition(NodeId const nodeId,
-                                                        PortType const portType,
-                                                        PortIndex const portIndex) const
+void DefaultHorizontalNodeGeometry::layout(NodeId const nodeId, NodeGeometry &geometry) const
 {
-    QPointF p = portPosition(nodeId, portType, portIndex);
+    QSize const &size = geometry.size;
 
-    QRectF rect = portTextRect(nodeId, portType, portIndex);
+    QRectF const &capRect = geometry.captionRect;
 
-    p.setY(p.y() + rect.height() / 4.0);
+    unsigned int const step = _portSize + _portSpasing;
 
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+    for (PortType const portType : {PortType::In, PortType::Out}) {
+        auto &ports = geometry.ports[static_cast<int>(portType)];
 
-    switch (portType) {
-    case PortType::In:
-        p.setX(_portSpasing);
-        break;
+        for (PortIndex portIndex = 0ul; portIndex < ports.size(); ++portIndex) {
+            PortGeometry &port = ports[portIndex];
 
-    case PortType::Out:
-        p.setX(size.width() - _portSpasing - rect.width());
-        break;
+            double totalHeight = 0.0;
 
-    default:
-        break;
-    }
+            totalHeight += capRect.height();
+            totalHeight += _portSpasing;
 
-    return p;
-}
+            totalHeight += step * portIndex;
+            totalHeight += step / 2.0;
 
-QRectF DefaultHorizontalNodeGeometry::captionRect(NodeId const nodeId) const
-{
-    if (!_graphModel.nodeData<bool>(nodeId, NodeRole::CaptionVisible))
-        return QRect();
+            double const x = (portType == PortType::In) ? 0.0 : size.width();
 
-    QString name = _graphModel.nodeData<QString>(nodeId, NodeRole::Caption);
+            port.position = QPointF(x, totalHeight);
 
-    return _boldFontMetrics.boundingRect(name);
-}
+            port.textPosition = QPointF((portType == PortType::In)
+                                            ? _portSpasing
+                                            : size.width() - _portSpasing - port.textRect.width(),
+                                        totalHeight + port.textRect.height() / 4.0);
+        }
+    }
 
-QPointF DefaultHorizontalNodeGeometry::captionPosition(NodeId const nodeId) const
-{
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
-    return QPointF(0.5 * (size.width() - captionRect(nodeId).width()),
-                   0.5 * _portSpasing + captionRect(nodeId).height());
-}
+    geometry.captionPosition = QPointF(0.5 * (size.width() - capRect.width()),
+                                       0.5 * _portSpasing + capRect.height());
 
-QPointF DefaultHorizontalNodeGeometry::widgetPosition(NodeId const nodeId) const
-{
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+    geometry.widgetPosition = QPointF();
 
-    unsigned int captionHeight = captionRect(nodeId).height()*2;
+    unsigned int captionHeight = capRect.height() * 2;
 
     bool isEmbeded = _graphModel.nodeData(nodeId, NodeRole::WidgetEmbeddable).value<bool>();
     auto w = _graphModel.nodeData<QWidget *>(nodeId, NodeRole::Widget);
 
     if (isEmbeded && w) {
+        double const x = 2.0 * _portSpasing
+                         + geometry.portsTextAdvance[static_cast<int>(PortType::In)];
+
         // If the widget wants to use as much vertical space as possible,
         // place it immediately after the caption.
         if (w->sizePolicy().verticalPolicy() & QSizePolicy::ExpandFlag) {
-            return QPointF(2.0 * _portSpasing + maxPortsTextAdvance(nodeId, PortType::In),
-                           captionHeight);
+            geometry.widgetPosition = QPointF(x, captionHeight);
         } else {
-            return QPointF(2.0 * _portSpasing + maxPortsTextAdvance(nodeId, PortType::In),
-                           (captionHeight + size.height() - w->height()) / 2.0);
+            geometry.widgetPosition = QPointF(x, (captionHeight + size.height() - w->height())
+                                                     / 2.0);
         }
     }
-    return QPointF();
-}
-
-QRect DefaultHorizontalNodeGeometry::resizeHandleRect(NodeId const nodeId) const
-{
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
-
-    unsigned int rectSize = 7;
-
-    return QRect(size.width() - _portSpasing, size.height() - _portSpasing, rectSize, rectSize);
-}
-
-QRectF DefaultHorizontalNodeGeometry::portTextRect(NodeId const nodeId,
-                                                   PortType const portType,
-                                                   PortIndex const portIndex) const
-{
-    QString s;
-    if (_graphModel.portData<bool>(nodeId, portType, portIndex, PortRole::CaptionVisible)) {
-        s = _graphModel.portData<QString>(nodeId, portType, portIndex, PortRole::Caption);
-    }
-    // else {
-    //     auto portData = _graphModel.portData(nodeId, portType, portIndex, PortRole::DataType);
-    //
-    //     s = portData.value<NodeDataType>().name;
-    // }
-    // PortRole::CaptionVisible 为false时不计算文本框宽度
-    return _fontMetrics.boundingRect(s);
-
-}
-
-unsigned int DefaultHorizontalNodeGeometry::maxVerticalPortsExtent(NodeId const nodeId) const
-{
-    PortCount nInPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::InPortCount);
-
-    PortCount nOutPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::OutPortCount);
-
-    unsigned int maxNumOfEntries = std::max(nInPorts, nOutPorts);
-    unsigned int step = _portSize + _portSpasing;
-
-    return step * maxNumOfEntries;
-}
-
-unsigned int DefaultHorizontalNodeGeometry::maxPortsTextAdvance(NodeId const nodeId,
-                                                                PortType const portType) const
-{
-    unsigned int width = 0;
-
-    size_t const n = _graphModel
-                         .nodeData(nodeId,
-                                   (portType == PortType::Out) ? NodeRole::OutPortCount
-                                                               : NodeRole::InPortCount)
-                         .toUInt();
-
-    for (PortIndex portIndex = 0ul; portIndex < n; ++portIndex) {
-        QString name;
-
-        if (_graphModel.portData<bool>(nodeId, portType, portIndex, PortRole::CaptionVisible)) {
-            name = _graphModel.portData<QString>(nodeId, portType, portIndex, PortRole::Caption);
-        }
-        // else {
-        //     NodeDataType portData = _graphModel.portData<NodeDataType>(nodeId,
-        //                                                                portType,
-        //                                                                portIndex,
-        //                                                                PortRole::DataType);
-        //
-        //     name = portData.name;
-        // }
-        // PortRole::CaptionVisible 为false时不计算宽度
-
-#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
-        width = std::max(unsigned(_fontMetrics.horizontalAdvance(name)), width);
-#else
-        width = std::max(unsigned(_fontMetrics.width(name)), width);
-#endif
-    }
-
-    return width;
 }
 
 } // namespace QtNodes
@@ -22,32 +22,52 @@ void DefaultNodePainter::paint(QPainter *painter, NodeGraphicsObject &ngo) const
     //AbstractNodeGeometry & geometry = ngo.nodeScene()->nodeGeometry();
     //geometry.recomputeSizeIfFontChanged(painter->font());
 
+    LevelOfDetail const detail = ngo.nodeScene()->levelOfDetail(painter->worldTransform());
+
+    if (detail == LevelOfDetail::Minimal) {
+        drawFlatNodeRect(painter, ngo);
+        return;
+    }
+
     drawNodeRect(painter, ngo);
 
-    drawConnectionPoints(painter, ngo);
+    if (detail == LevelOfDetail::Full) {
+        drawConnectionPoints(painter, ngo);
 
-    drawFilledConnectionPoints(painter, ngo);
+        drawFilledConnectionPoints(painter, ngo);
+    }
 
     drawNodeCaption(painter, ngo);
 
-    drawEntryLabels(painter, ngo);
+    if (detail == LevelOfDetail::Full)
+        drawEntryLabels(painter, ngo);
 
     drawResizeRect(painter, ngo);
 }
 
-void DefaultNodePainter::drawNodeRect(QPainter *painter, NodeGraphicsObject &ngo) const
+void DefaultNodePainter::drawFlatNodeRect(QPainter *painter, NodeGraphicsObject &ngo) const
 {
-    AbstractGraphModel &model = ngo.graphModel();
+    NodeId const nodeId = ngo.nodeId();
 
+    QSize const size = ngo.nodeScene()->nodeGeometry().size(nodeId);
+
+    NodeStyle const &nodeStyle = ngo.nodeScene()->nodeStyle(nodeId);
+
+    // Only the selection is kept distinguishable at this scale.
+    painter->fillRect(QRectF(0, 0, size.width(), size.height()),
+                      ngo.isSelected() ? nodeStyle.SelectedBoundaryColor
+                                       : nodeStyle.GradientColor1);
+}
+
+void DefaultNodePainter::drawNodeRect(QPainter *painter, NodeGraphicsObject &ngo) const
+{
     NodeId const nodeId = ngo.nodeId();
 
     AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
 
     QSize size = geometry.size(nodeId);
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-
-    NodeStyle nodeStyle(json.object());
+    NodeStyle const &nodeStyle = ngo.nodeScene()->nodeStyle(nodeId);
 
     auto color = ngo.isSelected() ? nodeStyle.SelectedBoundaryColor : nodeStyle.NormalBoundaryColor;
 
@@ -81,8 +101,7 @@ void DefaultNodePainter::drawConnectionPoints(QPainter *painter, NodeGraphicsObj
     NodeId const nodeId = ngo.nodeId();
     AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-    NodeStyle nodeStyle(json.object());
+    NodeStyle const &nodeStyle = ngo.nodeScene()->nodeStyle(nodeId);
 
     auto const &connectionStyle = StyleCollection::connectionStyle();
 
@@ -99,8 +118,7 @@ void DefaultNodePainter::drawConnectionPoints(QPainter *painter, NodeGraphicsObj
         for (PortIndex portIndex = 0; portIndex < n; ++portIndex) {
             QPointF p = geometry.portPosition(nodeId, portType, portIndex);
 
-            auto const &dataType = model.portData(nodeId, portType, portIndex, PortRole::DataType)
-                                       .value<NodeDataType>();
+            PortInfo const info = model.portInfo(nodeId, portType, portIndex);
 
             double r = 1.0;
 
@@ -133,7 +151,7 @@ void DefaultNodePainter::drawConnectionPoints(QPainter *painter, NodeGraphicsObj
             }
 
             if (connectionStyle.useDataDefinedColors()) {
-                painter->setBrush(connectionStyle.normalColor(dataType.id));
+                painter->setBrush(connectionStyle.normalColor(info.dataType.id, info.typeHandle));
             } else {
                 painter->setBrush(nodeStyle.ConnectionPointColor);
             }
@@ -153,8 +171,7 @@ void DefaultNodePainter::drawFilledConnectionPoints(QPainter *painter, NodeGraph
     NodeId const nodeId = ngo.nodeId();
     AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-    NodeStyle nodeStyle(json.object());
+    NodeStyle const &nodeStyle = ngo.nodeScene()->nodeStyle(nodeId);
 
     auto diameter = nodeStyle.ConnectionPointDiameter;
 
@@ -168,16 +185,13 @@ void DefaultNodePainter::drawFilledConnectionPoints(QPainter *painter, NodeGraph
         for (PortIndex portIndex = 0; portIndex < n; ++portIndex) {
             QPointF p = geometry.portPosition(nodeId, portType, portIndex);
 
-            auto const &connected = model.connections(nodeId, portType, portIndex);
-
-            if (!connected.empty()) {
-                auto const &dataType = model
-                                           .portData(nodeId, portType, portIndex, PortRole::DataType)
-                                           .value<NodeDataType>();
+            if (model.connectionCount(nodeId, portType, portIndex) > 0) {
+                PortInfo const info = model.portInfo(nodeId, portType, portIndex);
 
                 auto const &connectionStyle = StyleCollection::connectionStyle();
                 if (connectionStyle.useDataDefinedColors()) {
-                    QColor const c = connectionStyle.normalColor(dataType.id);
+                    QColor const c = connectionStyle.normalColor(info.dataType.id,
+                                                                 info.typeHandle);
                     painter->setPen(c);
                     painter->setBrush(c);
                 } else {
@@ -207,8 +221,7 @@ void DefaultNodePainter::drawNodeCaption(QPainter *painter, NodeGraphicsObject &
 
     QPointF position = geometry.captionPosition(nodeId);
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-    NodeStyle nodeStyle(json.object());
+    NodeStyle const &nodeStyle = ngo.nodeScene()->nodeStyle(nodeId);
     // draw caption color
     painter->drawRoundedRect(0,
         0,
@@ -230,8 +243,7 @@ void DefaultNodePainter::drawEntryLabels(QPainter *painter, NodeGraphicsObject &
     NodeId const nodeId = ngo.nodeId();
     AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-    NodeStyle nodeStyle(json.object());
+    NodeStyle const &nodeStyle = ngo.nodeScene()->nodeStyle(nodeId);
 
     for (PortType portType : {PortType::Out, PortType::In}) {
         unsigned int n = model.nodeData<unsigned int>(nodeId,
@@ -240,19 +252,20 @@ void DefaultNodePainter::drawEntryLabels(QPainter *painter, NodeGraphicsObject &
                                                           : NodeRole::InPortCount);
 
         for (PortIndex portIndex = 0; portIndex < n; ++portIndex) {
-            auto const &connected = model.connections(nodeId, portType, portIndex);
+            bool const connected = model.connectionCount(nodeId, portType, portIndex) > 0;
 
             QPointF p = geometry.portTextPosition(nodeId, portType, portIndex);
 
-            if (connected.empty())
+            if (!connected)
                 painter->setPen(nodeStyle.FontColorFaded);
             else
                 painter->setPen(nodeStyle.FontColor);
 
             QString s;
 
-            if (model.portData<bool>(nodeId, portType, portIndex, PortRole::CaptionVisible)) {
-                s = model.portData<QString>(nodeId, portType, portIndex, PortRole::Caption);
+            PortInfo const info = model.portInfo(nodeId, portType, portIndex);
+            if (info.captionVisible) {
+                s = info.caption;
             }
 
             // else {
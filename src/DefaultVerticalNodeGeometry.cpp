@@ -10,7 +10,7 @@
 namespace QtNodes {
 
 DefaultVerticalNodeGeometry::DefaultVerticalNodeGeometry(AbstractGraphModel &graphModel)
-    : AbstractNodeGeometry(graphModel)
+    : CachedNodeGeometry(graphModel)
     , _portSize(20)
     , _portSpasing(10)
     , _fontMetrics(QFont())
@@ -23,12 +23,8 @@ DefaultVerticalNodeGeometry::DefaultVerticalNodeGeometry(AbstractGraphModel &gra
     _portSize = _fontMetrics.height();
 }
 
-QSize DefaultVerticalNodeGeometry::size(NodeId const nodeId) const
-{
-    return _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
-}
-
-void DefaultVerticalNodeGeometry::recomputeSize(NodeId const nodeId) const
+QSize DefaultVerticalNodeGeometry::measuredSize(NodeId const nodeId,
+                                                NodeGeometry const &geometry) const
 {
     unsigned int height = _portSpasing; // maxHorizontalPortsExtent(nodeId);
 
@@ -39,23 +35,26 @@ void DefaultVerticalNodeGeometry::recomputeSize(NodeId const nodeId) const
         height = std::max(height, static_cast<unsigned int>(w->height()));
     }
 
-    QRectF const capRect = captionRect(nodeId);
+    QRectF const &capRect = geometry.captionRect;
 
     height += capRect.height();
 
     height += _portSpasing;
     height += _portSpasing;
 
-    PortCount nInPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::InPortCount);
-    PortCount nOutPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::OutPortCount);
+    int const in = static_cast<int>(PortType::In);
+    int const out = static_cast<int>(PortType::Out);
+
+    PortCount nInPorts = geometry.ports[in].size();
+    PortCount nOutPorts = geometry.ports[out].size();
 
     // Adding double step (top and bottom) to reserve space for port captions.
 
-    height += portCaptionsHeight(nodeId, PortType::In);
-    height += portCaptionsHeight(nodeId, PortType::Out);
+    height += geometry.portCaptionsHeight[in];
+    height += geometry.portCaptionsHeight[out];
 
-    unsigned int inPortWidth = maxPortsTextAdvance(nodeId, PortType::In);
-    unsigned int outPortWidth = maxPortsTextAdvance(nodeId, PortType::Out);
+    unsigned int inPortWidth = geometry.portsTextAdvance[in];
+    unsigned int outPortWidth = geometry.portsTextAdvance[out];
 
     unsigned int totalInPortsWidth = nInPorts > 0
                                          ? inPortWidth * nInPorts + _portSpasing * (nInPorts - 1)
@@ -76,149 +75,120 @@ void DefaultVerticalNodeGeometry::recomputeSize(NodeId const nodeId) const
     width += _portSpasing;
     width += _portSpasing;
 
-    QSize size(width, height);
+    return QSize(width, height);
+}
+
+QRect DefaultVerticalNodeGeometry::resizeHandleRect(NodeId const nodeId) const
+{
+    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+
+    unsigned int rectSize = 7;
 
-    _graphModel.setNodeData(nodeId, NodeRole::Size, size);
+    return QRect(size.width() - rectSize, size.height() - rectSize, rectSize, rectSize);
 }
 
-QPointF DefaultVerticalNodeGeometry::portPosition(NodeId const nodeId,
-                                                  PortType const portType,
-                                                  PortIndex const portIndex) const
+void DefaultVerticalNodeGeometry::measure(NodeId const nodeId, NodeGeometry &geometry) const
 {
-    QPointF result;
+    geometry.captionRect = QRectF();
 
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+    if (_graphModel.nodeData<bool>(nodeId, NodeRole::CaptionVisible)) {
+        geometry.captionRect = _boldFontMetrics.boundingRect(
+            _graphModel.nodeData<QString>(nodeId, NodeRole::Caption));
+    }
 
-    switch (portType) {
-    case PortType::In: {
-        unsigned int inPortWidth = maxPortsTextAdvance(nodeId, PortType::In) + _portSpasing;
+    for (PortType const portType : {PortType::In, PortType::Out}) {
+        size_t const n = _graphModel
+                             .nodeData(nodeId,
+                                       (portType == PortType::Out) ? NodeRole::OutPortCount
+                                                                   : NodeRole::InPortCount)
+                             .toUInt();
 
-        PortCount nInPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::InPortCount);
+        auto &ports = geometry.ports[static_cast<int>(portType)];
 
-        double x = (size.width() - (nInPorts - 1) * inPortWidth) / 2.0 + portIndex * inPortWidth;
+        ports.resize(n);
 
-        double y = 0.0;
+        unsigned int width = 0;
 
-        result = QPointF(x, y);
+        bool anyCaptionVisible = false;
 
-        break;
-    }
+        for (PortIndex portIndex = 0ul; portIndex < n; ++portIndex) {
+            PortInfo const info = _graphModel.portInfo(nodeId, portType, portIndex);
 
-    case PortType::Out: {
-        unsigned int outPortWidth = maxPortsTextAdvance(nodeId, PortType::Out) + _portSpasing;
-        PortCount nOutPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::OutPortCount);
+            QString const &name = info.captionVisible ? info.caption : info.dataType.name;
 
-        double x = (size.width() - (nOutPorts - 1) * outPortWidth) / 2.0 + portIndex * outPortWidth;
+            anyCaptionVisible = anyCaptionVisible || info.captionVisible;
 
-        double y = size.height();
+            ports[portIndex].textRect = _fontMetrics.boundingRect(name);
 
-        result = QPointF(x, y);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+            width = std::max(unsigned(_fontMetrics.horizontalAdvance(name)), width);
+#else
+            width = std::max(unsigned(_fontMetrics.width(name)), width);
+#endif
+        }
 
-        break;
-    }
+        geometry.portsTextAdvance[static_cast<int>(portType)] = width;
 
-    default:
-        break;
+        geometry.portCaptionsHeight[static_cast<int>(portType)] = anyCaptionVisible ? _portSpasing
+                                                                                    : 0;
     }
-
-    return result;
 }
 
-QPointF DefaultVerticalNodeGeometry::portTextPosition(NodeId const nodeId,
-                                                      PortType const portType,
-                                                      PortIndex const portIndex) const
+void DefaultVerticalNodeGeometry::layout(NodeId const nodeId, NodeGeometry &geometry) const
 {
-    QPointF p = portPosition(nodeId, portType, portIndex);
-
-    QRectF rect = portTextRect(nodeId, portType, portIndex);
-
-    p.setX(p.x() - rect.width() / 2.0);
+    QSize const &size = geometry.size;
 
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+    QRectF const &capRect = geometry.captionRect;
 
-    switch (portType) {
-    case PortType::In:
-        p.setY(5.0 + rect.height());
-        break;
+    for (PortType const portType : {PortType::In, PortType::Out}) {
+        auto &ports = geometry.ports[static_cast<int>(portType)];
 
-    case PortType::Out:
-        p.setY(size.height() - 5.0);
-        break;
+        double const portWidth = geometry.portsTextAdvance[static_cast<int>(portType)]
+                                 + _portSpasing;
 
-    default:
-        break;
-    }
+        double const left = (size.width() - (ports.size() - 1.0) * portWidth) / 2.0;
 
-    return p;
-}
+        for (PortIndex portIndex = 0ul; portIndex < ports.size(); ++portIndex) {
+            PortGeometry &port = ports[portIndex];
 
-QRectF DefaultVerticalNodeGeometry::captionRect(NodeId const nodeId) const
-{
-    if (!_graphModel.nodeData<bool>(nodeId, NodeRole::CaptionVisible))
-        return QRect();
+            double const x = left + portIndex * portWidth;
 
-    QString name = _graphModel.nodeData<QString>(nodeId, NodeRole::Caption);
+            double const y = (portType == PortType::In) ? 0.0 : size.height();
 
-    return _boldFontMetrics.boundingRect(name);
-}
+            port.position = QPointF(x, y);
 
-QPointF DefaultVerticalNodeGeometry::captionPosition(NodeId const nodeId) const
-{
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+            port.textPosition = QPointF(x - port.textRect.width() / 2.0,
+                                        (portType == PortType::In)
+                                            ? 5.0 + port.textRect.height()
+                                            : size.height() - 5.0);
+        }
+    }
 
-    unsigned int step = portCaptionsHeight(nodeId, PortType::In);
+    unsigned int step = geometry.portCaptionsHeight[static_cast<int>(PortType::In)];
     step += _portSpasing;
 
-    auto rect = captionRect(nodeId);
-
-    return QPointF(0.5 * (size.width() - rect.width()), step + rect.height());
-}
+    geometry.captionPosition = QPointF(0.5 * (size.width() - capRect.width()),
+                                       step + capRect.height());
 
-QPointF DefaultVerticalNodeGeometry::widgetPosition(NodeId const nodeId) const
-{
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+    geometry.widgetPosition = QPointF();
 
-    unsigned int captionHeight = captionRect(nodeId).height()*2;
+    unsigned int captionHeight = capRect.height() * 2;
 
     bool isEmbeded = _graphModel.nodeData(nodeId, NodeRole::WidgetEmbeddable).value<bool>();
     auto w = _graphModel.nodeData<QWidget *>(nodeId, NodeRole::Widget);
 
     if (isEmbeded && w) {
+        double const x = _portSpasing + geometry.portsTextAdvance[static_cast<int>(PortType::In)];
+
         // If the widget wants to use as much vertical space as possible,
         // place it immediately after the caption.
         if (w->sizePolicy().verticalPolicy() & QSizePolicy::ExpandFlag) {
-            return QPointF(_portSpasing + maxPortsTextAdvance(nodeId, PortType::In), captionHeight);
+            geometry.widgetPosition = QPointF(x, captionHeight);
         } else {
-            return QPointF(_portSpasing + maxPortsTextAdvance(nodeId, PortType::In),
-                           (captionHeight + size.height() - w->height()) / 2.0);
+            geometry.widgetPosition = QPointF(x, (captionHeight + size.height() - w->height())
+                                                     / 2.0);
         }
     }
-    return QPointF();
-}
-
-QRect DefaultVerticalNodeGeometry::resizeHandleRect(NodeId const nodeId) const
-{
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
-
-    unsigned int rectSize = 7;
-
-    return QRect(size.width() - rectSize, size.height() - rectSize, rectSize, rectSize);
-}
-
-QRectF DefaultVerticalNodeGeometry::portTextRect(NodeId const nodeId,
-                                                 PortType const portType,
-                                                 PortIndex const portIndex) const
-{
-    QString s;
-    if (_graphModel.portData<bool>(nodeId, portType, portIndex, PortRole::CaptionVisible)) {
-        s = _graphModel.portData<QString>(nodeId, portType, portIndex, PortRole::Caption);
-    } else {
-        auto portData = _graphModel.portData(nodeId, portType, portIndex, PortRole::DataType);
-
-        s = portData.value<NodeDataType>().name;
-    }
-
-    return _fontMetrics.boundingRect(s);
 }
 
 unsigned int DefaultVerticalNodeGeometry::maxHorizontalPortsExtent(NodeId const nodeId) const
@@ -233,74 +203,4 @@ unsigned int DefaultVerticalNodeGeometry::maxHorizontalPortsExtent(NodeId const
     return step * maxNumOfEntries;
 }
 
-unsigned int DefaultVerticalNodeGeometry::maxPortsTextAdvance(NodeId const nodeId,
-                                                              PortType const portType) const
-{
-    unsigned int width = 0;
-
-    size_t const n = _graphModel
-                         .nodeData(nodeId,
-                                   (portType == PortType::Out) ? NodeRole::OutPortCount
-                                                               : NodeRole::InPortCount)
-                         .toUInt();
-
-    for (PortIndex portIndex = 0ul; portIndex < n; ++portIndex) {
-        QString name;
-
-        if (_graphModel.portData<bool>(nodeId, portType, portIndex, PortRole::CaptionVisible)) {
-            name = _graphModel.portData<QString>(nodeId, portType, portIndex, PortRole::Caption);
-        } else {
-            NodeDataType portData = _graphModel.portData<NodeDataType>(nodeId,
-                                                                       portType,
-                                                                       portIndex,
-                                                                       PortRole::DataType);
-
-            name = portData.name;
-        }
-
-#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
-        width = std::max(unsigned(_fontMetrics.horizontalAdvance(name)), width);
-#else
-        width = std::max(unsigned(_fontMetrics.width(name)), width);
-#endif
-    }
-
-    return width;
-}
-
-unsigned int DefaultVerticalNodeGeometry::portCaptionsHeight(NodeId const nodeId,
-                                                             PortType const portType) const
-{
-    unsigned int h = 0;
-
-    switch (portType) {
-    case PortType::In: {
-        PortCount nInPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::InPortCount);
-        for (PortIndex i = 0; i < nInPorts; ++i) {
-            if (_graphModel.portData<bool>(nodeId, PortType::In, i, PortRole::CaptionVisible)) {
-                h += _portSpasing;
-                break;
-            }
-        }
-        break;
-    }
-
-    case PortType::Out: {
-        PortCount nOutPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::OutPortCount);
-        for (PortIndex i = 0; i < nOutPorts; ++i) {
-            if (_graphModel.portData<bool>(nodeId, PortType::Out, i, PortRole::CaptionVisible)) {
-                h += _portSpasing;
-                break;
-            }
-        }
-        break;
-    }
-
-    default:
-        break;
-    }
-
-    return h;
-}
-
 } // namespace QtNodes
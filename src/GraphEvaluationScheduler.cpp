@@ -0,0 +1,99 @@
+#include "GraphEvaluationScheduler.hpp"
+
+#include "WorkStealingThreadPool.hpp"
+
+namespace QtNodes {
+
+GraphEvaluationScheduler::GraphEvaluationScheduler(WorkStealingThreadPool &pool)
+    : _pool(pool)
+    , _remaining{0}
+{}
+
+std::size_t GraphEvaluationScheduler::addTask(Task task, bool mainThreadOnly)
+{
+    _nodes.push_back(Node{std::move(task), mainThreadOnly, 0u, {}});
+
+    return _nodes.size() - 1;
+}
+
+void GraphEvaluationScheduler::addDependency(std::size_t before, std::size_t after)
+{
+    _nodes[before].successors.push_back(after);
+    ++_nodes[after].predecessors;
+}
+
+void GraphEvaluationScheduler::run()
+{
+    if (_nodes.empty())
+        return;
+
+    _unfinishedPredecessors.reset(new std::atomic<unsigned int>[_nodes.size()]);
+    for (std::size_t i = 0; i < _nodes.size(); ++i) {
+        _unfinishedPredecessors[i] = _nodes[i].predecessors;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _remaining = _nodes.size();
+    }
+
+    for (std::size_t i = 0; i < _nodes.size(); ++i) {
+        if (_nodes[i].predecessors == 0)
+            schedule(i);
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    for (;;) {
+        _changed.wait(lock, [this]() { return !_mainThreadQueue.empty() || _remaining == 0; });
+
+        if (_mainThreadQueue.empty())
+            break;
+
+        std::size_t const index = _mainThreadQueue.front();
+        _mainThreadQueue.pop_front();
+
+        lock.unlock();
+        execute(index);
+        lock.lock();
+    }
+
+    if (_error)
+        std::rethrow_exception(_error);
+}
+
+void GraphEvaluationScheduler::schedule(std::size_t const index)
+{
+    if (_nodes[index].mainThreadOnly) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _mainThreadQueue.push_back(index);
+        _changed.notify_one();
+    } else {
+        _pool.submit([this, index]() { execute(index); });
+    }
+}
+
+void GraphEvaluationScheduler::execute(std::size_t const index)
+{
+    try {
+        _nodes[index].task();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_error)
+            _error = std::current_exception();
+    }
+
+    for (std::size_t const successor : _nodes[index].successors) {
+        if (--_unfinishedPredecessors[successor] == 0)
+            schedule(successor);
+    }
+
+    // The counter is only touched under the lock: once it reaches zero
+    // `run()` may return and destroy the scheduler as soon as the lock is
+    // released, so nothing may be accessed after that.
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (--_remaining == 0)
+        _changed.notify_one();
+}
+
+} // namespace QtNodes
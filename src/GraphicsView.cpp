@@ -51,6 +51,11 @@ GraphicsView::GraphicsView(QWidget *parent)
 
     setScaleRange(0.3, 2);
 
+    connect(this, &GraphicsView::scaleChanged, this, [this]() {
+        if (auto scene = nodeScene())
+            scene->updateViewScale();
+    });
+
     // Sets the scene rect to its maximum possible ranges to avoid autu scene range
     // re-calculation when expanding the all QGraphicsItems common rect.
     int maxSize = 32767;
@@ -73,10 +78,27 @@ QAction *GraphicsView::deleteSelectionAction() const
     return _deleteSelectionAction;
 }
 
+GraphicsView::~GraphicsView()
+{
+    // Detached first so that the scene no longer counts this view's scale.
+    if (auto scene = nodeScene()) {
+        QGraphicsView::setScene(nullptr);
+        scene->updateViewScale();
+    }
+}
+
 void GraphicsView::setScene(BasicGraphicsScene *scene)
 {
+    BasicGraphicsScene *previous = nodeScene();
+
     QGraphicsView::setScene(scene);
 
+    if (previous && previous != scene)
+        previous->updateViewScale();
+
+    if (scene)
+        scene->updateViewScale();
+
     {
         // setup actions
         delete _clearSelectionAction;
@@ -0,0 +1,37 @@
+#include "NodeData.hpp"
+
+#include <QtCore/QHash>
+
+#include <mutex>
+
+namespace QtNodes {
+
+unsigned int NodeDataType::intern(QString const &id)
+{
+    if (id.isEmpty())
+        return 0;
+
+    // Port tables are rebuilt on every node update, most lookups never reach the mutex.
+    thread_local QHash<QString, unsigned int> localHandles;
+
+    auto local = localHandles.constFind(id);
+    if (local != localHandles.constEnd())
+        return local.value();
+
+    static std::mutex mutex;
+    static QHash<QString, unsigned int> handles;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = handles.constFind(id);
+    if (it == handles.constEnd()) {
+        // Zero is reserved for the empty id.
+        it = handles.insert(id, static_cast<unsigned int>(handles.size()) + 1);
+    }
+
+    localHandles.insert(id, it.value());
+
+    return it.value();
+}
+
+} // namespace QtNodes
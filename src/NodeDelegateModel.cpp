@@ -2,14 +2,94 @@
 
 #include "StyleCollection.hpp"
 
+#include <QtCore/QDebug>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+
+#include <exception>
+#include <mutex>
+
 namespace QtNodes {
 
+namespace {
+
+// The protected aliases of NodeDelegateModel, for the helpers below.
+using PortDataList = std::vector<std::pair<PortIndex, std::shared_ptr<NodeData>>>;
+using ComputeFunction = std::function<PortDataList(CancellationToken const &)>;
+
+} // namespace
+
+struct AsyncComputeState
+{
+    /// Guards `model`, which is reset when the model is destroyed.
+    std::mutex mutex;
+    NodeDelegateModel *model = nullptr;
+
+    // The rest is only accessed from the thread owning the model.
+    bool running = false;
+    CancellationToken runningToken;
+    ComputeFunction pending;
+    std::vector<std::shared_ptr<NodeData>> outputs;
+};
+
+namespace {
+
+class ComputeRunnable : public QRunnable
+{
+public:
+    using Delivery = std::function<void(PortDataList)>;
+
+    ComputeRunnable(ComputeFunction function, CancellationToken token, Delivery delivery)
+        : _function(std::move(function))
+        , _token(std::move(token))
+        , _delivery(std::move(delivery))
+    {}
+
+    void run() override
+    {
+        PortDataList outputs;
+
+        if (!_token.isCancelled()) {
+            try {
+                outputs = _function(_token);
+            } catch (std::exception const &e) {
+                qWarning() << "Asynchronous node computation failed:" << e.what();
+                _token.cancel();
+            }
+        }
+
+        // Delivered even when cancelled, the model starts the queued
+        // computation then.
+        _delivery(std::move(outputs));
+    }
+
+private:
+    ComputeFunction _function;
+    CancellationToken _token;
+    Delivery _delivery;
+};
+
+} // namespace
+
 NodeDelegateModel::NodeDelegateModel()
     : _nodeStyle(StyleCollection::nodeStyle())
 {
     // Derived classes can initialize specific style here
 }
 
+NodeDelegateModel::~NodeDelegateModel()
+{
+    if (_asyncState) {
+        {
+            std::lock_guard<std::mutex> lock(_asyncState->mutex);
+            _asyncState->model = nullptr;
+        }
+
+        _asyncState->runningToken.cancel();
+        _asyncState->pending = nullptr;
+    }
+}
+
 QJsonObject NodeDelegateModel::save() const
 {
     QJsonObject modelJson;
@@ -64,4 +144,126 @@ unsigned int NodeDelegateModel::nPorts(PortType portType) const
         break;
     }
 }
+
+bool NodeDelegateModel::isComputing() const
+{
+    return _asyncState && _asyncState->running;
+}
+
+void NodeDelegateModel::computeAsync(ComputeFunction function)
+{
+    asyncState();
+
+    if (_asyncState->running) {
+        // Coalesced: the newest request replaces the one waiting.
+        _asyncState->runningToken.cancel();
+        _asyncState->pending = std::move(function);
+        return;
+    }
+
+    startCompute(std::move(function));
+
+    Q_EMIT computingStarted();
+}
+
+void NodeDelegateModel::cancelCompute()
+{
+    if (!_asyncState)
+        return;
+
+    _asyncState->runningToken.cancel();
+    _asyncState->pending = nullptr;
+}
+
+void NodeDelegateModel::setComputedOutData(PortDataList const &outputs)
+{
+    // Also called directly, e.g. to clear the outputs without computing.
+    auto &stored = asyncState().outputs;
+
+    for (auto const &output : outputs) {
+        if (output.first >= stored.size())
+            stored.resize(output.first + 1);
+
+        stored[output.first] = output.second;
+    }
+
+    for (auto const &output : outputs) {
+        Q_EMIT dataUpdated(output.first);
+    }
+}
+
+std::shared_ptr<NodeData> NodeDelegateModel::computedOutData(PortIndex const port) const
+{
+    if (!_asyncState || port >= _asyncState->outputs.size())
+        return nullptr;
+
+    return _asyncState->outputs[port];
+}
+
+AsyncComputeState &NodeDelegateModel::asyncState()
+{
+    if (!_asyncState) {
+        _asyncState = std::make_shared<AsyncComputeState>();
+        _asyncState->model = this;
+    }
+
+    return *_asyncState;
+}
+
+void NodeDelegateModel::startCompute(ComputeFunction function)
+{
+    std::shared_ptr<AsyncComputeState> state = _asyncState;
+
+    CancellationToken token;
+
+    state->running = true;
+    state->runningToken = token;
+
+    auto delivery = [state, token](PortDataList outputs) {
+        std::lock_guard<std::mutex> lock(state->mutex);
+
+        NodeDelegateModel *model = state->model;
+        if (model == nullptr)
+            return;
+
+        // Queued events of a deleted model are discarded by Qt.
+        QMetaObject::invokeMethod(
+            model,
+            [model, outputs, token]() { model->finishCompute(outputs, token); },
+            Qt::QueuedConnection);
+    };
+
+    QThreadPool::globalInstance()->start(
+        new ComputeRunnable(std::move(function), token, std::move(delivery)));
+}
+
+void NodeDelegateModel::finishCompute(PortDataList const &outputs, CancellationToken const &token)
+{
+    AsyncComputeState &state = *_asyncState;
+
+    state.running = false;
+
+    if (state.pending) {
+        ComputeFunction next = std::move(state.pending);
+        state.pending = nullptr;
+
+        startCompute(std::move(next));
+    }
+
+    // Any newer request cancels the running computation, so a result which
+    // was not cancelled is the newest one.
+    if (!token.isCancelled())
+        setComputedOutData(outputs);
+
+    if (!state.running)
+        Q_EMIT computingFinished();
+}
+
+void NodeDelegateModel::setInDataBatch(
+    std::vector<std::pair<PortIndex, std::shared_ptr<NodeData>>> const &inputs)
+{
+    for (auto const &input : inputs) {
+        setInData(input.second, input.first);
+    }
+}
 } // namespace QtNodes
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <vector>
 
 #include <QtWidgets/QGraphicsEffect>
 #include <QtWidgets/QtWidgets>
@@ -14,7 +15,6 @@
 #include "ConnectionIdUtils.hpp"
 #include "NodeConnectionInteraction.hpp"
 #include "StyleCollection.hpp"
-#include "UndoCommands.hpp"
 
 namespace QtNodes {
 
@@ -33,15 +33,14 @@ NodeGraphicsObject::NodeGraphicsObject(BasicGraphicsScene &scene, NodeId nodeId)
 
     setCacheMode(QGraphicsItem::DeviceCoordinateCache);
 
-    QJsonObject nodeStyleJson = _graphModel.nodeData(_nodeId, NodeRole::Style).toJsonObject();
-
-    NodeStyle nodeStyle(nodeStyleJson);
+    NodeStyle const &nodeStyle = scene.nodeStyle(_nodeId);
 
     {
         auto effect = new QGraphicsDropShadowEffect;
         effect->setOffset(4, 4);
         effect->setBlurRadius(20);
         effect->setColor(nodeStyle.ShadowColor);
+        effect->setEnabled(scene.viewLevelOfDetail() == LevelOfDetail::Full);
 
         setGraphicsEffect(effect);
     }
@@ -177,14 +176,14 @@ void NodeGraphicsObject::setGeometryChanged()
 
 void NodeGraphicsObject::moveConnections() const
 {
-    auto const &connected = _graphModel.allConnectionIds(_nodeId);
+    BasicGraphicsScene *scene = nodeScene();
 
-    for (auto &cnId : connected) {
-        auto cgo = nodeScene()->connectionGraphicsObject(cnId);
+    _graphModel.visitAllConnections(_nodeId, [scene](ConnectionId const &cnId) {
+        auto cgo = scene->connectionGraphicsObject(cnId);
 
         if (cgo)
             cgo->move();
-    }
+    });
 }
 
 void NodeGraphicsObject::reactToConnection(ConnectionGraphicsObject const *cgo)
@@ -204,7 +203,7 @@ void NodeGraphicsObject::paint(QPainter *painter, QStyleOptionGraphicsItem const
 QVariant NodeGraphicsObject::itemChange(GraphicsItemChange change, const QVariant &value)
 {
     if (change == ItemScenePositionHasChanged && scene()) {
-        moveConnections();
+        nodeScene()->scheduleConnectionUpdate(_nodeId);
     }
 
     return QGraphicsObject::itemChange(change, value);
@@ -242,12 +241,8 @@ void NodeGraphicsObject::mousePressEvent(QGraphicsSceneMouseEvent *event)
         } else // initialize new Connection
         {
             if (portToCheck == PortType::Out) {
-                auto const outPolicy = _graphModel
-                                           .portData(_nodeId,
-                                                     portToCheck,
-                                                     portIndex,
-                                                     PortRole::ConnectionPolicyRole)
-                                           .value<ConnectionPolicy>();
+                auto const outPolicy
+                    = _graphModel.portInfo(_nodeId, portToCheck, portIndex).connectionPolicy;
 
                 if (!connected.empty() && outPolicy == ConnectionPolicy::One) {
                     for (auto &cnId : connected) {
@@ -310,6 +305,8 @@ void NodeGraphicsObject::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
             // Passes the new size to the model.
             geometry.recomputeSize(_nodeId);
 
+            nodeScene()->updateNodeIndex(_nodeId);
+
             update();
 
             moveConnections();
@@ -319,7 +316,11 @@ void NodeGraphicsObject::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
     } else {
         auto diff = event->pos() - event->lastPos();
 
-        nodeScene()->undoStack().push(new MoveNodeCommand(nodeScene(), diff));
+        // The undo command is pushed once, on release.
+        if (!nodeScene()->nodeDragActive())
+            nodeScene()->beginNodeDrag();
+
+        nodeScene()->dragNodes(diff);
 
         event->accept();
     }
@@ -339,6 +340,8 @@ void NodeGraphicsObject::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
         QGraphicsObject::mouseReleaseEvent(event);
     }
 
+    nodeScene()->endNodeDrag();
+
     // position connections precisely after fast node move
     moveConnections();
 
@@ -348,11 +351,26 @@ void NodeGraphicsObject::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
 void NodeGraphicsObject::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
 {
     // bring all the colliding nodes to background
-    QList<QGraphicsItem *> overlapItems = collidingItems();
+    BasicGraphicsScene *scene = nodeScene();
+
+    if (scene->nodeIndexEnabled()) {
+        std::vector<NodeId> overlapNodes;
+
+        scene->nodeIndex().query(sceneBoundingRect(), overlapNodes);
+
+        for (NodeId const nodeId : overlapNodes) {
+            NodeGraphicsObject *ngo = scene->nodeGraphicsObject(nodeId);
+
+            if (ngo && ngo->zValue() > 0.0)
+                ngo->setZValue(0.0);
+        }
+    } else {
+        QList<QGraphicsItem *> overlapItems = collidingItems();
 
-    for (QGraphicsItem *item : overlapItems) {
-        if (item->zValue() > 0.0) {
-            item->setZValue(0.0);
+        for (QGraphicsItem *item : overlapItems) {
+            if (item->zValue() > 0.0) {
+                item->setZValue(0.0);
+            }
         }
     }
 
@@ -0,0 +1,238 @@
+#include "NodeSpatialIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace QtNodes {
+
+namespace {
+
+/// Keeps cell coordinates and their differences far from overflowing.
+constexpr qreal maxCellCoordinate = 1 << 29;
+
+/// Nodes covering more cells are kept in a list checked by every query.
+constexpr qreal maxCellsPerNode = 1024;
+
+bool oversized(int const left, int const top, int const right, int const bottom)
+{
+    return (static_cast<qreal>(right) - left + 1) * (static_cast<qreal>(bottom) - top + 1)
+           > maxCellsPerNode;
+}
+
+quint64 cellKey(int const x, int const y)
+{
+    return (static_cast<quint64>(static_cast<quint32>(x)) << 32) | static_cast<quint32>(y);
+}
+
+/// Order of the ids in a cell does not matter.
+void eraseId(std::vector<NodeId> &ids, NodeId const nodeId)
+{
+    auto it = std::find(ids.begin(), ids.end(), nodeId);
+
+    if (it != ids.end()) {
+        *it = ids.back();
+        ids.pop_back();
+    }
+}
+
+} // namespace
+
+NodeSpatialIndex::NodeSpatialIndex(qreal cellSize)
+    : _cellSize(std::max<qreal>(cellSize, 1.0))
+    , _stamp(0)
+{}
+
+void NodeSpatialIndex::setCellSize(qreal cellSize)
+{
+    _cellSize = std::max<qreal>(cellSize, 1.0);
+
+    _cells.clear();
+    _oversizedNodes.clear();
+
+    for (auto &entry : _entries) {
+        entry.second.cells = cellRange(entry.second.rect);
+
+        insertIntoCells(entry.first, entry.second.cells);
+    }
+}
+
+void NodeSpatialIndex::update(NodeId const nodeId, QRectF const &sceneRect)
+{
+    CellRange const cells = cellRange(sceneRect);
+
+    auto it = _entries.find(nodeId);
+
+    if (it == _entries.end()) {
+        _entries.emplace(nodeId, Entry{sceneRect, cells, 0});
+
+        insertIntoCells(nodeId, cells);
+        return;
+    }
+
+    Entry &entry = it->second;
+
+    entry.rect = sceneRect;
+
+    if (entry.cells.left == cells.left && entry.cells.top == cells.top
+        && entry.cells.right == cells.right && entry.cells.bottom == cells.bottom)
+        return;
+
+    removeFromCells(nodeId, entry.cells);
+
+    entry.cells = cells;
+
+    insertIntoCells(nodeId, cells);
+}
+
+void NodeSpatialIndex::remove(NodeId const nodeId)
+{
+    auto it = _entries.find(nodeId);
+
+    if (it == _entries.end())
+        return;
+
+    removeFromCells(nodeId, it->second.cells);
+
+    _entries.erase(it);
+}
+
+void NodeSpatialIndex::clear()
+{
+    _entries.clear();
+    _cells.clear();
+    _oversizedNodes.clear();
+}
+
+void NodeSpatialIndex::query(QRectF const &rect, std::vector<NodeId> &result) const
+{
+    CellRange const cells = cellRange(rect);
+
+    qreal const cellCount = (static_cast<qreal>(cells.right) - cells.left + 1)
+                            * (static_cast<qreal>(cells.bottom) - cells.top + 1);
+
+    // Queries larger than the populated area are cheaper over the nodes.
+    if (cellCount > static_cast<qreal>(_cells.size())) {
+        for (auto const &entry : _entries) {
+            if (entry.second.rect.intersects(rect))
+                result.push_back(entry.first);
+        }
+        return;
+    }
+
+    for (NodeId const nodeId : _oversizedNodes) {
+        if (_entries.find(nodeId)->second.rect.intersects(rect))
+            result.push_back(nodeId);
+    }
+
+    unsigned int const stamp = nextStamp();
+
+    for (int x = cells.left; x <= cells.right; ++x) {
+        for (int y = cells.top; y <= cells.bottom; ++y) {
+            auto cell = _cells.find(cellKey(x, y));
+
+            if (cell == _cells.end())
+                continue;
+
+            for (NodeId const nodeId : cell->second) {
+                Entry const &entry = _entries.find(nodeId)->second;
+
+                if (entry.stamp == stamp || !entry.rect.intersects(rect))
+                    continue;
+
+                entry.stamp = stamp;
+                result.push_back(nodeId);
+            }
+        }
+    }
+}
+
+void NodeSpatialIndex::query(QPointF const &point, std::vector<NodeId> &result) const
+{
+    for (NodeId const nodeId : _oversizedNodes) {
+        if (_entries.find(nodeId)->second.rect.contains(point))
+            result.push_back(nodeId);
+    }
+
+    auto cell = _cells.find(cellKey(cellCoordinate(point.x()), cellCoordinate(point.y())));
+
+    if (cell == _cells.end())
+        return;
+
+    // A node is registered once per cell, so no duplicates are possible.
+    for (NodeId const nodeId : cell->second) {
+        if (_entries.find(nodeId)->second.rect.contains(point))
+            result.push_back(nodeId);
+    }
+}
+
+int NodeSpatialIndex::cellCoordinate(qreal const value) const
+{
+    qreal const cell = std::floor(value / _cellSize);
+
+    if (std::isnan(cell))
+        return 0;
+
+    return static_cast<int>(qBound(-maxCellCoordinate, cell, maxCellCoordinate));
+}
+
+NodeSpatialIndex::CellRange NodeSpatialIndex::cellRange(QRectF const &rect) const
+{
+    QRectF const r = rect.normalized();
+
+    return CellRange{cellCoordinate(r.left()),
+                     cellCoordinate(r.top()),
+                     cellCoordinate(r.right()),
+                     cellCoordinate(r.bottom())};
+}
+
+void NodeSpatialIndex::insertIntoCells(NodeId const nodeId, CellRange const &cells)
+{
+    if (oversized(cells.left, cells.top, cells.right, cells.bottom)) {
+        _oversizedNodes.push_back(nodeId);
+        return;
+    }
+
+    for (int x = cells.left; x <= cells.right; ++x) {
+        for (int y = cells.top; y <= cells.bottom; ++y) {
+            _cells[cellKey(x, y)].push_back(nodeId);
+        }
+    }
+}
+
+void NodeSpatialIndex::removeFromCells(NodeId const nodeId, CellRange const &cells)
+{
+    if (oversized(cells.left, cells.top, cells.right, cells.bottom)) {
+        eraseId(_oversizedNodes, nodeId);
+        return;
+    }
+
+    for (int x = cells.left; x <= cells.right; ++x) {
+        for (int y = cells.top; y <= cells.bottom; ++y) {
+            auto cell = _cells.find(cellKey(x, y));
+
+            if (cell == _cells.end())
+                continue;
+
+            eraseId(cell->second, nodeId);
+
+            if (cell->second.empty())
+                _cells.erase(cell);
+        }
+    }
+}
+
+unsigned int NodeSpatialIndex::nextStamp() const
+{
+    if (++_stamp == 0) {
+        // The counter wrapped around; old stamps could match again.
+        for (auto const &entry : _entries) {
+            entry.second.stamp = 0;
+        }
+
+        _stamp = 1;
+    }
+
+    return _stamp;
+}
+
+} // namespace QtNodes
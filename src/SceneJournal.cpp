@@ -0,0 +1,388 @@
+#include "SceneJournal.hpp"
+
+#include "ConnectionIdUtils.hpp"
+#include "DataFlowGraphModel.hpp"
+
+#include <QtCore/QFile>
+#include <QtCore/QIODevice>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QSaveFile>
+#include <QtCore/QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+namespace QtNodes {
+
+namespace {
+
+/// Snapshot header: the magic followed by the little-endian generation.
+char const SnapshotMagic[4] = {'Q', 'N', 'S', 'J'};
+
+int const SnapshotHeaderSize = sizeof(SnapshotMagic) + sizeof(quint64);
+
+QString const generationKey = QStringLiteral("generation");
+
+QByteArray journalHeader(quint64 const generation)
+{
+    QJsonObject header;
+    header[generationKey] = QString::number(generation);
+
+    QByteArray line = QJsonDocument(header).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    return line;
+}
+
+} // namespace
+
+SceneJournal::SceneJournal(DataFlowGraphModel &graphModel, QObject *parent)
+    : QObject(parent)
+    , _graphModel(graphModel)
+    , _compactionThreshold(100)
+    , _snapshotRequired(true)
+    , _deltaCount(0)
+    , _generation(0)
+{
+    connect(&_graphModel, &AbstractGraphModel::nodeCreated, this, &SceneJournal::onNodeCreated);
+
+    connect(&_graphModel, &AbstractGraphModel::nodeDeleted, this, &SceneJournal::onNodeDeleted);
+
+    connect(&_graphModel,
+            &AbstractGraphModel::connectionCreated,
+            this,
+            &SceneJournal::onConnectionCreated);
+
+    connect(&_graphModel,
+            &AbstractGraphModel::connectionDeleted,
+            this,
+            &SceneJournal::onConnectionDeleted);
+
+    connect(&_graphModel,
+            &AbstractGraphModel::batchUpdateFinished,
+            this,
+            &SceneJournal::onBatchUpdateFinished);
+
+    connect(&_graphModel, &AbstractGraphModel::nodePositionUpdated, this, [this](NodeId nodeId) {
+        mark(nodeId, Moved);
+    });
+
+    // Data flowing through the ports is recomputed after loading, so only
+    // explicit updates mark the internal data as changed.
+    connect(&_graphModel, &AbstractGraphModel::nodeUpdated, this, [this](NodeId nodeId) {
+        mark(nodeId, DataChanged);
+    });
+}
+
+bool SceneJournal::hasChanges() const
+{
+    return !_changedNodes.empty() || !_deletedNodes.empty() || !_createdConnections.empty()
+           || !_deletedConnections.empty();
+}
+
+void SceneJournal::markNodeChanged(NodeId const nodeId)
+{
+    mark(nodeId, DataChanged);
+}
+
+void SceneJournal::setCompactionThreshold(int threshold)
+{
+    _compactionThreshold = std::max(threshold, 1);
+}
+
+bool SceneJournal::save(QString const &snapshotFile, QString const &journalFile)
+{
+    if (_snapshotRequired || _deltaCount >= _compactionThreshold)
+        return writeSnapshot(snapshotFile, journalFile);
+
+    if (!hasChanges())
+        return true;
+
+    QFile journal(journalFile);
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Append))
+        return false;
+
+    QByteArray line = (journal.size() == 0) ? journalHeader(_generation) : QByteArray();
+    line.append(QJsonDocument(takeDelta()).toJson(QJsonDocument::Compact));
+    line.append('\n');
+
+    if (journal.write(line) != line.size()) {
+        // The delta is lost and the journal may end with a partial line.
+        _snapshotRequired = true;
+        return false;
+    }
+
+    ++_deltaCount;
+
+    return true;
+}
+
+bool SceneJournal::load(QString const &snapshotFile, QString const &journalFile)
+{
+    QFile snapshot(snapshotFile);
+    if (!snapshot.open(QIODevice::ReadOnly))
+        return false;
+
+    QByteArray const data = snapshot.readAll();
+
+    if (data.size() < SnapshotHeaderSize
+        || std::memcmp(data.constData(), SnapshotMagic, sizeof(SnapshotMagic)) != 0)
+        return false;
+
+    _generation = qFromLittleEndian<quint64>(data.constData() + sizeof(SnapshotMagic));
+
+    _graphModel.loadBinary(QByteArray::fromRawData(data.constData() + SnapshotHeaderSize,
+                                                   data.size() - SnapshotHeaderSize));
+
+    _deltaCount = 0;
+    _snapshotRequired = false;
+
+    QFile journal(journalFile);
+
+    if (journal.open(QIODevice::ReadOnly) && !journal.atEnd()) {
+        QJsonObject const header = QJsonDocument::fromJson(journal.readLine()).object();
+
+        // A crash between committing a snapshot and truncating the journal
+        // leaves the deltas of the previous generation behind.
+        if (header[generationKey].toString() == QString::number(_generation))
+            _deltaCount = replay(_graphModel, journal);
+        else
+            _snapshotRequired = true;
+    }
+
+    clear();
+
+    return true;
+}
+
+QJsonObject SceneJournal::takeDelta()
+{
+    QJsonArray deletedConnections;
+    for (auto const &connectionId : _deletedConnections) {
+        deletedConnections.append(toJson(connectionId));
+    }
+
+    QJsonArray deletedNodes;
+    for (NodeId const nodeId : _deletedNodes) {
+        deletedNodes.append(static_cast<qint64>(nodeId));
+    }
+
+    QJsonArray nodes;
+    for (auto const &changed : _changedNodes) {
+        NodeId const nodeId = changed.first;
+
+        if (!_graphModel.nodeExists(nodeId))
+            continue;
+
+        if (changed.second & (Created | DataChanged)) {
+            nodes.append(_graphModel.saveNode(nodeId));
+        } else {
+            QPointF const pos = _graphModel.nodeData<QPointF>(nodeId, NodeRole::Position);
+
+            QJsonObject posJson;
+            posJson["x"] = pos.x();
+            posJson["y"] = pos.y();
+
+            QJsonObject nodeJson;
+            nodeJson["id"] = static_cast<qint64>(nodeId);
+            nodeJson["position"] = posJson;
+
+            nodes.append(nodeJson);
+        }
+    }
+
+    QJsonArray connections;
+    for (auto const &connectionId : _createdConnections) {
+        connections.append(toJson(connectionId));
+    }
+
+    QJsonObject delta;
+    delta["deleted-connections"] = deletedConnections;
+    delta["deleted-nodes"] = deletedNodes;
+    delta["nodes"] = nodes;
+    delta["connections"] = connections;
+
+    clear();
+
+    return delta;
+}
+
+void SceneJournal::clear()
+{
+    _changedNodes.clear();
+    _deletedNodes.clear();
+    _createdConnections.clear();
+    _deletedConnections.clear();
+}
+
+void SceneJournal::applyDelta(DataFlowGraphModel &graphModel, QJsonObject const &delta)
+{
+    GraphBatchUpdate const batch(graphModel);
+
+    for (QJsonValue const connection : delta["deleted-connections"].toArray()) {
+        graphModel.deleteConnection(fromJson(connection.toObject()));
+    }
+
+    for (QJsonValue const nodeId : delta["deleted-nodes"].toArray()) {
+        if (graphModel.nodeExists(nodeId.toInt()))
+            graphModel.deleteNode(nodeId.toInt());
+    }
+
+    for (QJsonValue const node : delta["nodes"].toArray()) {
+        QJsonObject const nodeJson = node.toObject();
+        NodeId const nodeId = nodeJson["id"].toInt();
+
+        if (!graphModel.nodeExists(nodeId)) {
+            graphModel.loadNode(nodeJson);
+            continue;
+        }
+
+        QJsonObject const posJson = nodeJson["position"].toObject();
+        graphModel.setNodeData(nodeId,
+                               NodeRole::Position,
+                               QPointF(posJson["x"].toDouble(), posJson["y"].toDouble()));
+
+        if (nodeJson.contains("internal-data")) {
+            auto *model = graphModel.delegateModel<NodeDelegateModel>(nodeId);
+            model->load(nodeJson["internal-data"].toObject());
+        }
+    }
+
+    for (QJsonValue const connection : delta["connections"].toArray()) {
+        ConnectionId const connectionId = fromJson(connection.toObject());
+
+        if (!graphModel.connectionExists(connectionId))
+            graphModel.addConnection(connectionId);
+    }
+}
+
+int SceneJournal::replay(DataFlowGraphModel &graphModel, QIODevice &journal)
+{
+    int count = 0;
+
+    while (!journal.atEnd()) {
+        QByteArray const line = journal.readLine();
+
+        QJsonParseError error;
+        QJsonDocument const document = QJsonDocument::fromJson(line, &error);
+
+        // Only the last line can be incomplete.
+        if (error.error != QJsonParseError::NoError)
+            break;
+
+        applyDelta(graphModel, document.object());
+
+        ++count;
+    }
+
+    return count;
+}
+
+void SceneJournal::onNodeCreated(NodeId const nodeId)
+{
+    // Already recorded by `onBatchUpdateFinished()`.
+    if (_graphModel.batchReplayActive())
+        return;
+
+    mark(nodeId, Created);
+}
+
+void SceneJournal::onNodeDeleted(NodeId const nodeId)
+{
+    // Already recorded by `onBatchUpdateFinished()`.
+    if (_graphModel.batchReplayActive())
+        return;
+
+    auto it = _changedNodes.find(nodeId);
+
+    bool const createdSinceSave = (it != _changedNodes.end()) && (it->second & Created);
+
+    if (it != _changedNodes.end())
+        _changedNodes.erase(it);
+
+    if (!createdSinceSave)
+        _deletedNodes.insert(nodeId);
+}
+
+void SceneJournal::onConnectionCreated(ConnectionId const connectionId)
+{
+    // Already recorded by `onBatchUpdateFinished()`.
+    if (_graphModel.batchReplayActive())
+        return;
+
+    _createdConnections.insert(connectionId);
+}
+
+void SceneJournal::onConnectionDeleted(ConnectionId const connectionId)
+{
+    // Already recorded by `onBatchUpdateFinished()`.
+    if (_graphModel.batchReplayActive())
+        return;
+
+    if (_createdConnections.erase(connectionId) == 0)
+        _deletedConnections.insert(connectionId);
+}
+
+void SceneJournal::onBatchUpdateFinished(GraphChanges const &changes)
+{
+    for (auto const &connectionId : changes.deletedConnections) {
+        onConnectionDeleted(connectionId);
+    }
+
+    for (NodeId const nodeId : changes.deletedNodes) {
+        onNodeDeleted(nodeId);
+    }
+
+    for (NodeId const nodeId : changes.createdNodes) {
+        onNodeCreated(nodeId);
+    }
+
+    for (auto const &connectionId : changes.createdConnections) {
+        onConnectionCreated(connectionId);
+    }
+}
+
+void SceneJournal::mark(NodeId const nodeId, unsigned int const change)
+{
+    _changedNodes[nodeId] |= change;
+}
+
+bool SceneJournal::writeSnapshot(QString const &snapshotFile, QString const &journalFile)
+{
+    quint64 const generation = _generation + 1;
+
+    QSaveFile snapshot(snapshotFile);
+    if (!snapshot.open(QIODevice::WriteOnly))
+        return false;
+
+    char header[SnapshotHeaderSize];
+    std::memcpy(header, SnapshotMagic, sizeof(SnapshotMagic));
+    qToLittleEndian<quint64>(generation, header + sizeof(SnapshotMagic));
+
+    snapshot.write(header, SnapshotHeaderSize);
+    snapshot.write(_graphModel.saveBinary());
+
+    if (!snapshot.commit())
+        return false;
+
+    _generation = generation;
+
+    // The deltas of the previous generation are skipped from now on, even
+    // if the journal cannot be rewritten.
+    clear();
+
+    QFile journal(journalFile);
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QByteArray const line = journalHeader(_generation);
+    if (journal.write(line) != line.size())
+        return false;
+
+    _snapshotRequired = false;
+    _deltaCount = 0;
+
+    return true;
+}
+
+} // namespace QtNodes
@@ -0,0 +1,347 @@
+#include "StreamingSceneLoader.hpp"
+
+#include "ConnectionIdUtils.hpp"
+#include "DataFlowGraphModel.hpp"
+
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace QtNodes {
+
+StreamingSceneLoader::StreamingSceneLoader(DataFlowGraphModel &graphModel, QObject *parent)
+    : QObject(parent)
+    , _graphModel(graphModel)
+    , _chunkSize(1 << 16)
+    , _stepSize(256)
+    , _concurrent(false)
+    , _running(false)
+{
+    _stepTimer.setSingleShot(true);
+    _stepTimer.setInterval(0);
+
+    connect(&_stepTimer, &QTimer::timeout, this, &StreamingSceneLoader::step);
+
+    reset(nullptr);
+}
+
+StreamingSceneLoader::~StreamingSceneLoader() = default;
+
+void StreamingSceneLoader::setChunkSize(qint64 chunkSize)
+{
+    _chunkSize = std::max<qint64>(chunkSize, 1);
+}
+
+void StreamingSceneLoader::setStepSize(int stepSize)
+{
+    _stepSize = std::max(stepSize, 1);
+}
+
+void StreamingSceneLoader::setConcurrent(bool concurrent)
+{
+    _concurrent = concurrent;
+}
+
+bool StreamingSceneLoader::load(QIODevice &device)
+{
+    cancel();
+
+    reset(&device);
+
+    _running = true;
+
+    try {
+        // Views receive the whole scene as one batch.
+        GraphBatchUpdate const batch(_graphModel);
+
+        processElements(-1);
+
+        restoreConnections();
+    } catch (std::exception const &e) {
+        fail(QString::fromLocal8Bit(e.what()));
+        return false;
+    }
+
+    _running = false;
+
+    Q_EMIT finished(true);
+
+    return true;
+}
+
+void StreamingSceneLoader::start(QIODevice *device)
+{
+    cancel();
+
+    reset(device);
+
+    _running = true;
+
+    _stepTimer.start();
+}
+
+void StreamingSceneLoader::cancel()
+{
+    _stepTimer.stop();
+
+    _running = false;
+
+    _connections.clear();
+    _nodeElements.clear();
+}
+
+void StreamingSceneLoader::step()
+{
+    if (!_running)
+        return;
+
+    bool more = false;
+
+    try {
+        if (!_device)
+            throw std::runtime_error("The scene device was destroyed during loading");
+
+        more = processElements(_stepSize);
+
+        if (!more)
+            restoreConnections();
+    } catch (std::exception const &e) {
+        fail(QString::fromLocal8Bit(e.what()));
+        return;
+    }
+
+    if (more) {
+        _stepTimer.start();
+    } else {
+        _running = false;
+
+        Q_EMIT finished(true);
+    }
+}
+
+void StreamingSceneLoader::reset(QIODevice *device)
+{
+    _device = device;
+    _errorString.clear();
+
+    _buffer.clear();
+    _position = 0;
+    _bytesRead = 0;
+    _depth = 0;
+    _inString = false;
+    _escaped = false;
+    _key.clear();
+    _currentKey.clear();
+    _section = Section::None;
+    _elementStart = -1;
+    _element.clear();
+    _connections.clear();
+    _nodeElements.clear();
+}
+
+bool StreamingSceneLoader::processElements(int maxElements)
+{
+    // Every step is a separate batch so that the nodes appear progressively.
+    GraphBatchUpdate const batch(_graphModel);
+
+    for (int i = 0; maxElements < 0 || i < maxElements; ++i) {
+        Section section = Section::None;
+
+        if (!nextElement(section)) {
+            if (_depth != 0 || _inString)
+                throw std::runtime_error("Unexpected end of the scene data");
+
+            flushNodeElements();
+
+            return false;
+        }
+
+        processElement(section);
+    }
+
+    flushNodeElements();
+
+    return true;
+}
+
+bool StreamingSceneLoader::nextElement(Section &section)
+{
+    for (;;) {
+        char const *data = _buffer.constData();
+        int const size = _buffer.size();
+
+        while (_position < size) {
+            char const c = data[_position++];
+
+            if (_inString) {
+                if (_escaped)
+                    _escaped = false;
+                else if (c == '\\')
+                    _escaped = true;
+                else if (c == '"')
+                    _inString = false;
+                else if (_depth == 1)
+                    _key.append(c);
+
+                continue;
+            }
+
+            switch (c) {
+            case '"':
+                _inString = true;
+                if (_depth == 1)
+                    _key.clear();
+                break;
+
+            case ':':
+                if (_depth == 1)
+                    _currentKey = _key;
+                break;
+
+            case ',':
+                if (_depth == 1)
+                    _currentKey.clear();
+                break;
+
+            case '{':
+            case '[':
+                ++_depth;
+
+                if (_depth == 2 && c == '[') {
+                    if (_currentKey == "nodes")
+                        _section = Section::Nodes;
+                    else if (_currentKey == "connections")
+                        _section = Section::Connections;
+                } else if (_depth == 3 && c == '{' && _section != Section::None) {
+                    _elementStart = _position - 1;
+                }
+                break;
+
+            case '}':
+            case ']':
+                --_depth;
+
+                if (_depth == 2 && _elementStart >= 0) {
+                    _element.append(data + _elementStart, _position - _elementStart);
+                    _elementStart = -1;
+
+                    section = _section;
+                    return true;
+                }
+
+                if (_depth == 1)
+                    _section = Section::None;
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        // Keep the unfinished element before the buffer is replaced.
+        if (_elementStart >= 0) {
+            _element.append(data + _elementStart, size - _elementStart);
+            _elementStart = 0;
+        }
+
+        if (!readChunk()) {
+            _elementStart = -1;
+            return false;
+        }
+    }
+}
+
+void StreamingSceneLoader::processElement(Section const section)
+{
+    if (_concurrent && section == Section::Nodes) {
+        _nodeElements.push_back(_element);
+        _element.clear();
+
+        if (_nodeElements.size() >= static_cast<std::size_t>(_stepSize))
+            flushNodeElements();
+
+        return;
+    }
+
+    QJsonParseError error;
+    QJsonDocument const document = QJsonDocument::fromJson(_element, &error);
+
+    _element.clear();
+
+    if (error.error != QJsonParseError::NoError) {
+        throw std::runtime_error(std::string("Malformed scene element before byte ")
+                                 + std::to_string(_bytesRead - _buffer.size() + _position)
+                                 + ": " + error.errorString().toStdString());
+    }
+
+    switch (section) {
+    case Section::Nodes:
+        _graphModel.loadNode(document.object());
+        break;
+
+    case Section::Connections:
+        _connections.push_back(fromJson(document.object()));
+        break;
+
+    case Section::None:
+        break;
+    }
+}
+
+void StreamingSceneLoader::flushNodeElements()
+{
+    if (_nodeElements.empty())
+        return;
+
+    _graphModel.loadNodesConcurrently(_nodeElements);
+
+    _nodeElements.clear();
+}
+
+bool StreamingSceneLoader::readChunk()
+{
+    if (!_device)
+        return false;
+
+    _buffer = _device->read(_chunkSize);
+    _position = 0;
+
+    if (_buffer.isEmpty())
+        return false;
+
+    _bytesRead += _buffer.size();
+
+    Q_EMIT progress(_bytesRead, _device->isSequential() ? -1 : _device->size());
+
+    return true;
+}
+
+void StreamingSceneLoader::restoreConnections()
+{
+    GraphBatchUpdate const batch(_graphModel);
+
+    for (auto const &connectionId : _connections) {
+        _graphModel.addConnection(connectionId);
+    }
+
+    _connections.clear();
+}
+
+void StreamingSceneLoader::fail(QString const &message)
+{
+    _stepTimer.stop();
+
+    _running = false;
+    _errorString = message;
+
+    _connections.clear();
+    _element.clear();
+    _nodeElements.clear();
+
+    Q_EMIT finished(false);
+}
+
+} // namespace QtNodes
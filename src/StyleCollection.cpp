@@ -20,9 +20,15 @@ GraphicsViewStyle const &StyleCollection::flowViewStyle()
     return instance()._flowViewStyle;
 }
 
+unsigned int StyleCollection::nodeStyleGeneration()
+{
+    return instance()._nodeStyleGeneration;
+}
+
 void StyleCollection::setNodeStyle(NodeStyle nodeStyle)
 {
     instance()._nodeStyle = nodeStyle;
+    ++instance()._nodeStyleGeneration;
 }
 
 void StyleCollection::setConnectionStyle(ConnectionStyle connectionStyle)
@@ -1,10 +1,16 @@
 #include "UndoCommands.hpp"
 
+#include <algorithm>
+#include <memory>
 #include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "BasicGraphicsScene.hpp"
 #include "ConnectionGraphicsObject.hpp"
+#include "ConnectionIdHash.hpp"
 #include "ConnectionIdUtils.hpp"
 #include "Definitions.hpp"
 #include "NodeGraphicsObject.hpp"
@@ -57,72 +63,202 @@ static QJsonObject serializeSelectedItems(BasicGraphicsScene *scene)
     return serializedScene;
 }
 
-static void insertSerializedItems(QJsonObject const &json, BasicGraphicsScene *scene)
+/// Node states at least this large are stored compressed.
+static int const compressionThreshold = 1024;
+
+/// Converts the output of `AbstractGraphModel::saveNode()`.
+static SerializedItems::Node nodeFromJson(QJsonObject nodeJson, BasicGraphicsScene *scene)
+{
+    NodeId const nodeId = nodeJson.take("id").toInt();
+    QJsonObject const posJson = nodeJson.take("position").toObject();
+
+    QByteArray const data = QJsonDocument(nodeJson).toJson(QJsonDocument::Compact);
+
+    return SerializedItems::Node{nodeId,
+                                 QPointF(posJson["x"].toDouble(), posJson["y"].toDouble()),
+                                 scene->nodeStatePool().share(data)};
+}
+
+/// Restores the input of `AbstractGraphModel::loadNode()`.
+static QJsonObject nodeToJson(SerializedItems::Node const &node)
+{
+    SerializedItems::NodeState const &state = *node.state;
+
+    QJsonObject nodeJson
+        = QJsonDocument::fromJson(state.compressed ? qUncompress(state.data) : state.data)
+              .object();
+
+    QJsonObject posJson;
+    posJson["x"] = node.position.x();
+    posJson["y"] = node.position.y();
+
+    nodeJson["id"] = static_cast<qint64>(node.id);
+    nodeJson["position"] = posJson;
+
+    return nodeJson;
+}
+
+static void insertSerializedItems(SerializedItems const &items, BasicGraphicsScene *scene)
 {
     AbstractGraphModel &graphModel = scene->graphModel();
 
-    QJsonArray const &nodesJsonArray = json["nodes"].toArray();
+    std::vector<NodeId> insertedNodes;
+    std::vector<ConnectionId> insertedConnections;
+
+    // The graphics objects are only created when the batch is closed.
+    auto selectInsertedItems = [&]() {
+        for (NodeId const id : insertedNodes) {
+            if (auto ngo = scene->nodeGraphicsObject(id)) {
+                ngo->setZValue(1.0);
+                ngo->setSelected(true);
+            }
+        }
 
-    for (QJsonValue node : nodesJsonArray) {
-        QJsonObject obj = node.toObject();
+        for (auto const &connId : insertedConnections) {
+            if (auto cgo = scene->connectionGraphicsObject(connId))
+                cgo->setSelected(true);
+        }
+    };
 
-        graphModel.loadNode(obj);
+    try {
+        GraphBatchUpdate const batch(graphModel);
 
-        auto id = obj["id"].toInt();
-        scene->nodeGraphicsObject(id)->setZValue(1.0);
-        scene->nodeGraphicsObject(id)->setSelected(true);
-    }
+        insertedNodes.reserve(items.nodes.size());
 
-    QJsonArray const &connJsonArray = json["connections"].toArray();
+        for (auto const &node : items.nodes) {
+            graphModel.loadNode(nodeToJson(node));
 
-    for (QJsonValue connection : connJsonArray) {
-        QJsonObject connJson = connection.toObject();
+            insertedNodes.push_back(node.id);
+        }
 
-        ConnectionId connId = fromJson(connJson);
+        insertedConnections.reserve(items.connections.size());
 
-        // Restore the connection
-        graphModel.addConnection(connId);
+        for (auto const &connId : items.connections) {
+            // Restore the connection
+            graphModel.addConnection(connId);
 
-        scene->connectionGraphicsObject(connId)->setSelected(true);
+            insertedConnections.push_back(connId);
+        }
+    } catch (...) {
+        // Callers clean up a failed insertion through the selection.
+        selectInsertedItems();
+        throw;
     }
+
+    selectInsertedItems();
 }
 
-static void deleteSerializedItems(QJsonObject &sceneJson, AbstractGraphModel &graphModel)
+static void deleteSerializedItems(SerializedItems const &items, AbstractGraphModel &graphModel)
 {
-    QJsonArray connectionJsonArray = sceneJson["connections"].toArray();
+    GraphBatchUpdate const batch(graphModel);
+
+    for (auto const &connId : items.connections) {
+        graphModel.deleteConnection(connId);
+    }
 
-    for (QJsonValueRef connection : connectionJsonArray) {
-        QJsonObject connJson = connection.toObject();
+    for (auto const &node : items.nodes) {
+        graphModel.deleteNode(node.id);
+    }
+}
 
-        ConnectionId connId = fromJson(connJson);
+static QPointF computeAverageNodePosition(SerializedItems const &items)
+{
+    QPointF averagePos(0, 0);
 
-        graphModel.deleteConnection(connId);
+    for (auto const &node : items.nodes) {
+        averagePos += node.position;
     }
 
-    QJsonArray nodesJsonArray = sceneJson["nodes"].toArray();
+    averagePos /= static_cast<double>(items.nodes.size());
 
-    for (QJsonValueRef node : nodesJsonArray) {
-        QJsonObject nodeJson = node.toObject();
-        graphModel.deleteNode(nodeJson["id"].toInt());
+    return averagePos;
+}
+
+static void offsetNodeGroup(SerializedItems &items, QPointF const &diff)
+{
+    for (auto &node : items.nodes) {
+        node.position += diff;
     }
 }
 
-static QPointF computeAverageNodePosition(QJsonObject const &sceneJson)
+//-------------------------------------
+
+std::size_t SerializedItems::memoryUsage() const
 {
-    QPointF averagePos(0, 0);
+    std::size_t size = sizeof(SerializedItems) + nodes.capacity() * sizeof(Node)
+                       + connections.capacity() * sizeof(ConnectionId);
+
+    for (auto const &node : nodes) {
+        size += sizeof(NodeState) + static_cast<std::size_t>(node.state->data.capacity());
+    }
 
-    QJsonArray nodesJsonArray = sceneJson["nodes"].toArray();
+    return size;
+}
+
+//-------------------------------------
+
+std::shared_ptr<SerializedItems::NodeState const> NodeStatePool::share(QByteArray data)
+{
+    using NodeState = SerializedItems::NodeState;
+
+    bool const compressed = data.size() >= compressionThreshold;
+    if (compressed)
+        data = qCompress(data);
 
-    for (QJsonValueRef node : nodesJsonArray) {
-        QJsonObject nodeJson = node.toObject();
+    std::size_t const key = qHash(data);
 
-        averagePos += QPointF(nodeJson["position"].toObject()["x"].toDouble(),
-                              nodeJson["position"].toObject()["y"].toDouble());
+    auto const range = _states.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (auto state = it->second.lock()) {
+            if (state->compressed == compressed && state->data == data)
+                return state;
+        }
     }
 
-    averagePos /= static_cast<double>(nodesJsonArray.size());
+    auto state = std::make_shared<NodeState const>(NodeState{data, compressed});
 
-    return averagePos;
+    _states.emplace(key, state);
+
+    if (_states.size() >= _sweepSize) {
+        for (auto it = _states.begin(); it != _states.end();) {
+            if (it->second.expired())
+                it = _states.erase(it);
+            else
+                ++it;
+        }
+
+        _sweepSize = std::max<std::size_t>(64, 2 * _states.size());
+    }
+
+    return state;
+}
+
+//-------------------------------------
+
+SceneUndoCommand::~SceneUndoCommand()
+{
+    if (_memoryTotal)
+        *_memoryTotal -= _accountedMemory;
+}
+
+void SceneUndoCommand::discard()
+{
+    releaseUndoData();
+
+    setObsolete(true);
+
+    if (_memoryTotal)
+        accountMemory(*_memoryTotal);
+}
+
+void SceneUndoCommand::accountMemory(std::size_t &total)
+{
+    std::size_t const usage = isObsolete() ? 0 : memoryUsage();
+
+    total = total - _accountedMemory + usage;
+
+    _memoryTotal = &total;
+    _accountedMemory = usage;
 }
 
 //-------------------------------------
@@ -131,7 +267,6 @@ CreateCommand::CreateCommand(BasicGraphicsScene *scene,
                              QString const name,
                              QPointF const &mouseScenePos)
     : _scene(scene)
-    , _sceneJson(QJsonObject())
 {
     _nodeId = _scene->graphModel().addNode(name);
     if (_nodeId != InvalidNodeId) {
@@ -143,19 +278,27 @@ CreateCommand::CreateCommand(BasicGraphicsScene *scene,
 
 void CreateCommand::undo()
 {
-    QJsonArray nodesJsonArray;
-    nodesJsonArray.append(_scene->graphModel().saveNode(_nodeId));
-    _sceneJson["nodes"] = nodesJsonArray;
+    _items.nodes.assign(1, nodeFromJson(_scene->graphModel().saveNode(_nodeId), _scene));
 
     _scene->graphModel().deleteNode(_nodeId);
 }
 
 void CreateCommand::redo()
 {
-    if (_sceneJson.empty() || _sceneJson["nodes"].toArray().empty())
+    if (_items.nodes.empty())
         return;
 
-    insertSerializedItems(_sceneJson, _scene);
+    insertSerializedItems(_items, _scene);
+}
+
+std::size_t CreateCommand::memoryUsage() const
+{
+    return sizeof(CreateCommand) + _items.memoryUsage();
+}
+
+void CreateCommand::releaseUndoData()
+{
+    _items = SerializedItems();
 }
 
 //-------------------------------------
@@ -165,74 +308,56 @@ DeleteCommand::DeleteCommand(BasicGraphicsScene *scene)
 {
     auto &graphModel = _scene->graphModel();
 
-    QJsonArray connJsonArray;
+    std::unordered_set<ConnectionId> connections;
+
+    auto addConnection = [&](ConnectionId const &cid) {
+        if (connections.insert(cid).second)
+            _items.connections.push_back(cid);
+    };
+
     // Delete the selected connections first, ensuring that they won't be
     // automatically deleted when selected nodes are deleted (deleting a
     // node deletes some connections as well)
     for (QGraphicsItem *item : _scene->selectedItems()) {
         if (auto c = qgraphicsitem_cast<ConnectionGraphicsObject *>(item)) {
-            auto const &cid = c->connectionId();
-
-            connJsonArray.append(toJson(cid));
+            addConnection(c->connectionId());
         }
     }
 
-    QJsonArray nodesJsonArray;
     // Delete the nodes; this will delete many of the connections.
     // Selected connections were already deleted prior to this loop,
     for (QGraphicsItem *item : _scene->selectedItems()) {
         if (auto n = qgraphicsitem_cast<NodeGraphicsObject *>(item)) {
             // saving connections attached to the selected nodes
-            for (auto const &cid : graphModel.allConnectionIds(n->nodeId())) {
-                connJsonArray.append(toJson(cid));
-            }
+            graphModel.visitAllConnections(n->nodeId(), addConnection);
 
-            nodesJsonArray.append(graphModel.saveNode(n->nodeId()));
+            _items.nodes.push_back(nodeFromJson(graphModel.saveNode(n->nodeId()), _scene));
         }
     }
 
     // If nothing is deleted, cancel this operation
-    if (connJsonArray.isEmpty() && nodesJsonArray.isEmpty())
+    if (_items.empty())
         setObsolete(true);
-
-    _sceneJson["nodes"] = nodesJsonArray;
-    _sceneJson["connections"] = connJsonArray;
 }
 
 void DeleteCommand::undo()
 {
-    insertSerializedItems(_sceneJson, _scene);
+    insertSerializedItems(_items, _scene);
 }
 
 void DeleteCommand::redo()
 {
-    deleteSerializedItems(_sceneJson, _scene->graphModel());
+    deleteSerializedItems(_items, _scene->graphModel());
 }
 
-//-------------------------------------
-
-void offsetNodeGroup(QJsonObject &sceneJson, QPointF const &diff)
+std::size_t DeleteCommand::memoryUsage() const
 {
-    QJsonArray nodesJsonArray = sceneJson["nodes"].toArray();
-
-    QJsonArray newNodesJsonArray;
-    for (QJsonValueRef node : nodesJsonArray) {
-        QJsonObject obj = node.toObject();
-
-        QPointF oldPos(obj["position"].toObject()["x"].toDouble(),
-                       obj["position"].toObject()["y"].toDouble());
-
-        oldPos += diff;
-
-        QJsonObject posJson;
-        posJson["x"] = oldPos.x();
-        posJson["y"] = oldPos.y();
-        obj["position"] = posJson;
-
-        newNodesJsonArray.append(obj);
-    }
+    return sizeof(DeleteCommand) + _items.memoryUsage();
+}
 
-    sceneJson["nodes"] = newNodesJsonArray;
+void DeleteCommand::releaseUndoData()
+{
+    _items = SerializedItems();
 }
 
 //-------------------------------------
@@ -268,23 +393,31 @@ PasteCommand::PasteCommand(BasicGraphicsScene *scene, QPointF const &mouseSceneP
     : _scene(scene)
     , _mouseScenePos(mouseScenePos)
 {
-    _newSceneJson = takeSceneJsonFromClipboard();
+    QJsonObject const sceneJson = takeSceneJsonFromClipboard();
+
+    for (QJsonValue const node : sceneJson["nodes"].toArray()) {
+        _items.nodes.push_back(nodeFromJson(node.toObject(), _scene));
+    }
 
-    if (_newSceneJson.empty() || _newSceneJson["nodes"].toArray().empty()) {
+    if (_items.nodes.empty()) {
         setObsolete(true);
         return;
     }
 
-    _newSceneJson = makeNewNodeIdsInScene(_newSceneJson);
+    for (QJsonValue const connection : sceneJson["connections"].toArray()) {
+        _items.connections.push_back(fromJson(connection.toObject()));
+    }
+
+    makeNewNodeIdsInScene(_items);
 
-    QPointF averagePos = computeAverageNodePosition(_newSceneJson);
+    QPointF averagePos = computeAverageNodePosition(_items);
 
-    offsetNodeGroup(_newSceneJson, _mouseScenePos - averagePos);
+    offsetNodeGroup(_items, _mouseScenePos - averagePos);
 }
 
 void PasteCommand::undo()
 {
-    deleteSerializedItems(_newSceneJson, _scene->graphModel());
+    deleteSerializedItems(_items, _scene->graphModel());
 }
 
 void PasteCommand::redo()
@@ -293,13 +426,12 @@ void PasteCommand::redo()
 
     // Ignore if pasted in content does not generate nodes.
     try {
-        insertSerializedItems(_newSceneJson, _scene);
+        insertSerializedItems(_items, _scene);
     } catch (...) {
         // If the paste does not work, delete all selected nodes and connections
         // `deleteNode(...)` implicitly removed connections
         auto &graphModel = _scene->graphModel();
 
-        QJsonArray nodesJsonArray;
         for (QGraphicsItem *item : _scene->selectedItems()) {
             if (auto n = qgraphicsitem_cast<NodeGraphicsObject *>(item)) {
                 graphModel.deleteNode(n->nodeId());
@@ -310,6 +442,16 @@ void PasteCommand::redo()
     }
 }
 
+std::size_t PasteCommand::memoryUsage() const
+{
+    return sizeof(PasteCommand) + _items.memoryUsage();
+}
+
+void PasteCommand::releaseUndoData()
+{
+    _items = SerializedItems();
+}
+
 QJsonObject PasteCommand::takeSceneJsonFromClipboard()
 {
     QClipboard const *clipboard = QApplication::clipboard();
@@ -325,52 +467,24 @@ QJsonObject PasteCommand::takeSceneJsonFromClipboard()
     return json.object();
 }
 
-QJsonObject PasteCommand::makeNewNodeIdsInScene(QJsonObject const &sceneJson)
+void PasteCommand::makeNewNodeIdsInScene(SerializedItems &items)
 {
     AbstractGraphModel &graphModel = _scene->graphModel();
 
     std::unordered_map<NodeId, NodeId> mapNodeIds;
 
-    QJsonArray nodesJsonArray = sceneJson["nodes"].toArray();
-
-    QJsonArray newNodesJsonArray;
-    for (QJsonValueRef node : nodesJsonArray) {
-        QJsonObject nodeJson = node.toObject();
-
-        NodeId oldNodeId = nodeJson["id"].toInt();
-
+    for (auto &node : items.nodes) {
         NodeId newNodeId = graphModel.newNodeId();
 
-        mapNodeIds[oldNodeId] = newNodeId;
+        mapNodeIds[node.id] = newNodeId;
 
-        // Replace NodeId in json
-        nodeJson["id"] = static_cast<qint64>(newNodeId);
-
-        newNodesJsonArray.append(nodeJson);
+        node.id = newNodeId;
     }
 
-    QJsonArray connectionJsonArray = sceneJson["connections"].toArray();
-
-    QJsonArray newConnJsonArray;
-    for (QJsonValueRef connection : connectionJsonArray) {
-        QJsonObject connJson = connection.toObject();
-
-        ConnectionId connId = fromJson(connJson);
-
-        ConnectionId newConnId{mapNodeIds[connId.outNodeId],
-                               connId.outPortIndex,
-                               mapNodeIds[connId.inNodeId],
-                               connId.inPortIndex};
-
-        newConnJsonArray.append(toJson(newConnId));
+    for (auto &connId : items.connections) {
+        connId.outNodeId = mapNodeIds[connId.outNodeId];
+        connId.inNodeId = mapNodeIds[connId.inNodeId];
     }
-
-    QJsonObject newSceneJson;
-
-    newSceneJson["nodes"] = newNodesJsonArray;
-    newSceneJson["connections"] = newConnJsonArray;
-
-    return newSceneJson;
 }
 
 //-------------------------------------
@@ -416,6 +530,7 @@ void ConnectCommand::redo()
 MoveNodeCommand::MoveNodeCommand(BasicGraphicsScene *scene, QPointF const &diff)
     : _scene(scene)
     , _diff(diff)
+    , _skipRedo(false)
 {
     _selectedNodes.clear();
     for (QGraphicsItem *item : _scene->selectedItems()) {
@@ -425,6 +540,15 @@ MoveNodeCommand::MoveNodeCommand(BasicGraphicsScene *scene, QPointF const &diff)
     }
 }
 
+MoveNodeCommand::MoveNodeCommand(BasicGraphicsScene *scene,
+                                 std::unordered_set<NodeId> nodes,
+                                 QPointF const &diff)
+    : _scene(scene)
+    , _selectedNodes(std::move(nodes))
+    , _diff(diff)
+    , _skipRedo(true)
+{}
+
 void MoveNodeCommand::undo()
 {
     for (auto nodeId : _selectedNodes) {
@@ -438,6 +562,11 @@ void MoveNodeCommand::undo()
 
 void MoveNodeCommand::redo()
 {
+    if (_skipRedo) {
+        _skipRedo = false;
+        return;
+    }
+
     for (auto nodeId : _selectedNodes) {
         auto oldPos = _scene->graphModel().nodeData(nodeId, NodeRole::Position).value<QPointF>();
 
@@ -463,4 +592,10 @@ bool MoveNodeCommand::mergeWith(QUndoCommand const *c)
     return false;
 }
 
+std::size_t MoveNodeCommand::memoryUsage() const
+{
+    // Node plus the bucket and link pointers of the hash set.
+    return sizeof(MoveNodeCommand) + _selectedNodes.size() * (sizeof(NodeId) + 2 * sizeof(void *));
+}
+
 } // namespace QtNodes
@@ -0,0 +1,126 @@
+#include "WorkStealingThreadPool.hpp"
+
+#include <algorithm>
+
+namespace QtNodes {
+
+namespace {
+
+/// Pool and queue index of the worker running on the current thread.
+thread_local WorkStealingThreadPool const *currentPool = nullptr;
+thread_local unsigned int currentWorker = 0;
+
+} // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(unsigned int threadCount)
+    : _pending{0}
+    , _nextWorker{0}
+    , _stopping{false}
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    _workers.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        _workers.push_back(std::make_unique<Worker>());
+    }
+
+    _threads.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        _threads.emplace_back([this, i]() { run(i); });
+    }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _stopping = true;
+    }
+
+    _wakeUp.notify_all();
+
+    for (auto &thread : _threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingThreadPool::submit(Task task)
+{
+    unsigned int const index = (currentPool == this)
+                                   ? currentWorker
+                                   : _nextWorker++ % static_cast<unsigned int>(_workers.size());
+
+    // Counted before queueing so that a fast worker never takes the counter
+    // below zero.
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        ++_pending;
+    }
+
+    {
+        Worker &worker = *_workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+
+    _wakeUp.notify_one();
+}
+
+void WorkStealingThreadPool::run(unsigned int const index)
+{
+    currentPool = this;
+    currentWorker = index;
+
+    for (;;) {
+        Task task;
+
+        if (popLocal(index, task) || steal(index, task)) {
+            --_pending;
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _wakeUp.wait(lock, [this]() { return _stopping || _pending > 0; });
+
+        if (_stopping && _pending == 0)
+            return;
+    }
+}
+
+bool WorkStealingThreadPool::popLocal(unsigned int const index, Task &task)
+{
+    Worker &worker = *_workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+
+    if (worker.tasks.empty())
+        return false;
+
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+
+    return true;
+}
+
+bool WorkStealingThreadPool::steal(unsigned int const index, Task &task)
+{
+    auto const n = static_cast<unsigned int>(_workers.size());
+
+    for (unsigned int i = 1; i < n; ++i) {
+        Worker &victim = *_workers[(index + i) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if (victim.tasks.empty())
+            continue;
+
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+
+        return true;
+    }
+
+    return false;
+}
+
+} // namespace QtNodes
@@ -5,14 +5,43 @@
 #include <QtCore/QList>
 #include <QtWidgets/QGraphicsScene>
 
+#include "BasicGraphicsScene.hpp"
 #include "NodeGraphicsObject.hpp"
 
 namespace QtNodes {
 
+static NodeGraphicsObject *locateIndexedNodeAt(QPointF scenePoint, BasicGraphicsScene &scene)
+{
+    std::vector<NodeId> candidates;
+
+    scene.nodeIndex().query(scenePoint, candidates);
+
+    NodeGraphicsObject *node = nullptr;
+
+    for (NodeId const nodeId : candidates) {
+        NodeGraphicsObject *ngo = scene.nodeGraphicsObject(nodeId);
+
+        if (!ngo || !ngo->isVisible() || !ngo->contains(ngo->mapFromScene(scenePoint)))
+            continue;
+
+        // Of equal z values the later node, created on top, wins.
+        if (!node || ngo->zValue() > node->zValue()
+            || (ngo->zValue() == node->zValue() && nodeId > node->nodeId()))
+            node = ngo;
+    }
+
+    return node;
+}
+
 NodeGraphicsObject *locateNodeAt(QPointF scenePoint,
                                  QGraphicsScene &scene,
                                  QTransform const &viewTransform)
 {
+    auto basicScene = dynamic_cast<BasicGraphicsScene *>(&scene);
+
+    if (basicScene && basicScene->nodeIndexEnabled())
+        return locateIndexedNodeAt(scenePoint, *basicScene);
+
     // items under cursor
     QList<QGraphicsItem *> items = scene.items(scenePoint,
                                                Qt::IntersectsItemShape,
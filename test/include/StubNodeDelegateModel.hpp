@@ -2,9 +2,9 @@
 
 #include <utility>
 
-#include <QtNodes/NodeDataModel>
+#include <QtNodes/NodeDelegateModel>
 
-class StubNodeDataModel : public QtNodes::NodeDataModel
+class StubNodeDelegateModel : public QtNodes::NodeDelegateModel
 {
 public:
     QString name() const override { return _name; }
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+
+#include <QtCore/QJsonObject>
+#include <QtCore/QPointF>
+
+#include <QtNodes/Definitions>
+#include <QtNodes/NodeDelegateModel>
+#include <QtNodes/NodeDelegateModelRegistry>
+
+/// Saves a free-form tag, which sets the content and the size of the node data.
+class TaggedModel : public QtNodes::NodeDelegateModel
+{
+public:
+    static QString Name() { return QStringLiteral("Tagged"); }
+
+    QString name() const override { return Name(); }
+
+    QtNodes::NodeDataType dataType(QtNodes::PortType, QtNodes::PortIndex) const override
+    {
+        return QtNodes::NodeDataType{"tag", "Tag"};
+    }
+
+    void setInData(std::shared_ptr<QtNodes::NodeData>, QtNodes::PortIndex) override {}
+
+    std::shared_ptr<QtNodes::NodeData> outData(QtNodes::PortIndex) override { return nullptr; }
+
+    QWidget *embeddedWidget() override { return nullptr; }
+
+    QJsonObject save() const override
+    {
+        QJsonObject modelJson = NodeDelegateModel::save();
+        modelJson["tag"] = tag;
+        return modelJson;
+    }
+
+    void load(QJsonObject const &modelJson) override { tag = modelJson["tag"].toString(); }
+
+    QString tag;
+};
+
+inline std::shared_ptr<QtNodes::NodeDelegateModelRegistry> taggedRegistry()
+{
+    auto ret = std::make_shared<QtNodes::NodeDelegateModelRegistry>();
+    ret->registerModel<TaggedModel>();
+    return ret;
+}
+
+/// A node in the format of `DataFlowGraphModel::saveNode()`.
+inline QJsonObject nodeJson(QtNodes::NodeId const nodeId,
+                            QJsonObject const &internalData,
+                            QPointF const &pos)
+{
+    QJsonObject posJson;
+    posJson["x"] = pos.x();
+    posJson["y"] = pos.y();
+
+    QJsonObject node;
+    node["id"] = static_cast<qint64>(nodeId);
+    node["internal-data"] = internalData;
+    node["position"] = posJson;
+
+    return node;
+}
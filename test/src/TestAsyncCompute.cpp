@@ -0,0 +1,195 @@
+#include <catch2/catch.hpp>
+
+#include "ApplicationSetup.hpp"
+
+#include <QtNodes/NodeData>
+#include <QtNodes/NodeDelegateModel>
+
+#include <QSignalSpy>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using QtNodes::CancellationToken;
+using QtNodes::NodeData;
+using QtNodes::NodeDataType;
+using QtNodes::NodeDelegateModel;
+using QtNodes::PortIndex;
+using QtNodes::PortType;
+
+namespace {
+
+class NumberData : public NodeData
+{
+public:
+    explicit NumberData(int number)
+        : _number(number)
+    {}
+
+    NodeDataType type() const override { return NodeDataType{"number", "Number"}; }
+
+    int number() const { return _number; }
+
+private:
+    int _number;
+};
+
+/// Squares its input on a worker thread, each computation waits for `release`.
+class SquareModel : public NodeDelegateModel
+{
+public:
+    using NodeDelegateModel::cancelCompute;
+
+    struct Shared
+    {
+        std::atomic<bool> release{false};
+
+        std::mutex mutex;
+        std::vector<int> startedInputs;
+        int cancelledRuns = 0;
+    };
+
+    QString name() const override { return QStringLiteral("Square"); }
+
+    NodeDataType dataType(PortType, PortIndex) const override
+    {
+        return NodeDataType{"number", "Number"};
+    }
+
+    std::shared_ptr<NodeData> outData(PortIndex port) override { return computedOutData(port); }
+
+    void setInData(std::shared_ptr<NodeData> data, PortIndex) override
+    {
+        int const value = std::static_pointer_cast<NumberData>(data)->number();
+
+        auto shared = _shared;
+
+        computeAsync([value, shared](CancellationToken const &token) -> PortDataList {
+            {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                shared->startedInputs.push_back(value);
+            }
+
+            while (!shared->release && !token.isCancelled()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            if (token.isCancelled()) {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                ++shared->cancelledRuns;
+                return {};
+            }
+
+            return {{0, std::make_shared<NumberData>(value * value)}};
+        });
+    }
+
+    QWidget *embeddedWidget() override { return nullptr; }
+
+    std::shared_ptr<Shared> shared() const { return _shared; }
+
+    QThread *deliveryThread = nullptr;
+
+protected:
+    void setComputedOutData(PortDataList const &outputs) override
+    {
+        deliveryThread = QThread::currentThread();
+
+        NodeDelegateModel::setComputedOutData(outputs);
+    }
+
+private:
+    std::shared_ptr<Shared> _shared = std::make_shared<Shared>();
+};
+
+int outputNumber(SquareModel &model)
+{
+    auto data = std::dynamic_pointer_cast<NumberData>(model.outData(0));
+    return data ? data->number() : -1;
+}
+
+} // namespace
+
+TEST_CASE("Asynchronous compute delivers results on the model thread", "[async]")
+{
+    auto setup = applicationSetup();
+
+    SquareModel model;
+
+    QSignalSpy updated(&model, &NodeDelegateModel::dataUpdated);
+    QSignalSpy finished(&model, &NodeDelegateModel::computingFinished);
+
+    model.shared()->release = true;
+    model.setInData(std::make_shared<NumberData>(3), 0);
+
+    CHECK(model.isComputing());
+
+    REQUIRE(finished.wait(5000));
+
+    CHECK_FALSE(model.isComputing());
+    CHECK(outputNumber(model) == 9);
+    CHECK(updated.count() == 1);
+    CHECK(model.deliveryThread == model.thread());
+}
+
+TEST_CASE("Asynchronous compute keeps only the newest request", "[async]")
+{
+    auto setup = applicationSetup();
+
+    SquareModel model;
+    auto shared = model.shared();
+
+    QSignalSpy started(&model, &NodeDelegateModel::computingStarted);
+    QSignalSpy updated(&model, &NodeDelegateModel::dataUpdated);
+    QSignalSpy finished(&model, &NodeDelegateModel::computingFinished);
+
+    model.setInData(std::make_shared<NumberData>(2), 0);
+    model.setInData(std::make_shared<NumberData>(3), 0);
+    model.setInData(std::make_shared<NumberData>(4), 0);
+
+    shared->release = true;
+
+    REQUIRE(finished.wait(5000));
+
+    CHECK(outputNumber(model) == 16);
+    CHECK(started.count() == 1);
+    CHECK(finished.count() == 1);
+
+    // The outdated results are never delivered.
+    CHECK(updated.count() == 1);
+
+    std::lock_guard<std::mutex> lock(shared->mutex);
+
+    // The request for 3 was replaced before it started.
+    CHECK(std::find(shared->startedInputs.begin(), shared->startedInputs.end(), 3)
+          == shared->startedInputs.end());
+    CHECK(shared->startedInputs.back() == 4);
+}
+
+TEST_CASE("Cancelled asynchronous compute delivers nothing", "[async]")
+{
+    auto setup = applicationSetup();
+
+    SquareModel model;
+    auto shared = model.shared();
+
+    QSignalSpy updated(&model, &NodeDelegateModel::dataUpdated);
+    QSignalSpy finished(&model, &NodeDelegateModel::computingFinished);
+
+    model.setInData(std::make_shared<NumberData>(5), 0);
+    model.cancelCompute();
+
+    shared->release = true;
+
+    REQUIRE(finished.wait(5000));
+
+    CHECK_FALSE(model.isComputing());
+    CHECK(model.outData(0) == nullptr);
+    CHECK(updated.count() == 0);
+}
@@ -0,0 +1,198 @@
+#include <catch2/catch.hpp>
+
+#include "ApplicationSetup.hpp"
+#include "TaggedModel.hpp"
+
+#include <QtNodes/ConnectionIdUtils>
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/NodeDelegateModelRegistry>
+#include <QtNodes/internal/BinarySceneFormat.hpp>
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QtEndian>
+
+#include <memory>
+#include <stdexcept>
+
+using QtNodes::BinarySceneReader;
+using QtNodes::ConnectionId;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::NodeId;
+
+namespace BinarySceneFormat = QtNodes::BinarySceneFormat;
+
+namespace {
+
+/// A saved node with the internal data a `modelName` model would save.
+QJsonObject nodeJson(NodeId const nodeId, QString const &modelName, double const x, double const y)
+{
+    QJsonObject internalData;
+    internalData["model-name"] = modelName;
+    internalData["caption"] = QStringLiteral("Node %1").arg(nodeId);
+    internalData["value"] = x * 0.5;
+
+    return ::nodeJson(nodeId, internalData, QPointF(x, y));
+}
+
+/// A scene in the format of `DataFlowGraphModel::save()`.
+QJsonObject sceneJson()
+{
+    QJsonArray nodes;
+    nodes.append(nodeJson(1, QStringLiteral("Source"), 10.25, -4.5));
+    nodes.append(nodeJson(2, QStringLiteral("Sink"), 210.5, 33.75));
+    nodes.append(nodeJson(7, QStringLiteral("Source"), -80.0, 120.125));
+
+    // A node without any internal data besides the model name.
+    QJsonObject bare;
+    bare["model-name"] = QStringLiteral("Sink");
+
+    QJsonObject bareNode = nodeJson(9, QStringLiteral("Sink"), 0.0, 0.0);
+    bareNode["internal-data"] = bare;
+    nodes.append(bareNode);
+
+    QJsonArray connections;
+    connections.append(QtNodes::toJson(ConnectionId{1, 0, 2, 0}));
+    connections.append(QtNodes::toJson(ConnectionId{7, 1, 2, 1}));
+    connections.append(QtNodes::toJson(ConnectionId{7, 0, 9, 0}));
+
+    QJsonObject scene;
+    scene["nodes"] = nodes;
+    scene["connections"] = connections;
+
+    return scene;
+}
+
+} // namespace
+
+TEST_CASE("Binary scene round trip", "[binary]")
+{
+    QJsonObject const scene = sceneJson();
+
+    QByteArray const data = BinarySceneFormat::fromSceneJson(scene);
+
+    REQUIRE(BinarySceneFormat::isBinaryScene(data));
+
+    SECTION("JSON to binary to JSON is lossless")
+    {
+        QString errorString;
+        QJsonObject const restored = BinarySceneFormat::toSceneJson(data, &errorString);
+
+        CHECK(errorString.isEmpty());
+        CHECK(restored == scene);
+    }
+
+    SECTION("Reader exposes the records")
+    {
+        BinarySceneReader const reader(data);
+
+        REQUIRE(reader.isValid());
+        CHECK(reader.nodeCount() == 4);
+        CHECK(reader.connectionCount() == 3);
+
+        CHECK(reader.nodeId(2) == 7);
+        CHECK(reader.nodePosition(2) == QPointF(-80.0, 120.125));
+        CHECK(reader.nodeModelName(2) == QStringLiteral("Source"));
+        CHECK(reader.connection(1) == ConnectionId{7, 1, 2, 1});
+    }
+}
+
+TEST_CASE("Malformed binary scenes are rejected", "[binary]")
+{
+    QByteArray const data = BinarySceneFormat::fromSceneJson(sceneJson());
+
+    SECTION("Not a binary scene")
+    {
+        QByteArray const json = QByteArrayLiteral("{\"nodes\": []}");
+
+        CHECK_FALSE(BinarySceneFormat::isBinaryScene(json));
+        CHECK_FALSE(BinarySceneReader(json).isValid());
+    }
+
+    SECTION("Truncated header")
+    {
+        BinarySceneReader const reader(data.left(BinarySceneFormat::HeaderSize - 1));
+
+        CHECK_FALSE(reader.isValid());
+        CHECK(reader.nodeCount() == 0);
+    }
+
+    SECTION("Truncated blob area")
+    {
+        QString errorString;
+        QJsonObject const scene = BinarySceneFormat::toSceneJson(data.left(data.size() - 1),
+                                                                 &errorString);
+
+        CHECK(scene.isEmpty());
+        CHECK_FALSE(errorString.isEmpty());
+    }
+
+    SECTION("Truncated record tables")
+    {
+        BinarySceneReader const reader(data.left(BinarySceneFormat::HeaderSize
+                                                 + BinarySceneFormat::NodeRecordSize));
+
+        CHECK_FALSE(reader.isValid());
+        CHECK(reader.nodeCount() == 0);
+        CHECK(reader.connectionCount() == 0);
+    }
+
+    SECTION("Unsupported version")
+    {
+        QByteArray newer = data;
+        qToLittleEndian<quint16>(BinarySceneFormat::Version + 1, newer.data() + 4);
+
+        BinarySceneReader const reader(newer);
+
+        CHECK_FALSE(reader.isValid());
+        CHECK(reader.errorString().contains(QStringLiteral("version")));
+    }
+}
+
+TEST_CASE("Corrupted node data is reported", "[binary]")
+{
+    auto setup = applicationSetup();
+
+    QJsonArray nodes;
+    nodes.append(nodeJson(1, QStringLiteral("Source"), 0.0, 0.0));
+
+    QJsonObject scene;
+    scene["nodes"] = nodes;
+    scene["connections"] = QJsonArray();
+
+    QByteArray data = BinarySceneFormat::fromSceneJson(scene);
+
+    // The internal data is the last blob, dropping its closing brace breaks the JSON.
+    REQUIRE(data.endsWith('}'));
+    data[data.size() - 1] = ' ';
+
+    BinarySceneReader const reader(data);
+
+    // The ranges are intact, only the content is broken.
+    REQUIRE(reader.isValid());
+
+    SECTION("Reader")
+    {
+        QString errorString;
+        QJsonObject const internalData = reader.nodeInternalData(0, &errorString);
+
+        CHECK_FALSE(errorString.isEmpty());
+        CHECK(internalData.keys() == QStringList{QStringLiteral("model-name")});
+    }
+
+    SECTION("Conversion to JSON")
+    {
+        QString errorString;
+
+        CHECK(BinarySceneFormat::toSceneJson(data, &errorString).isEmpty());
+        CHECK_FALSE(errorString.isEmpty());
+    }
+
+    SECTION("Graph model")
+    {
+        DataFlowGraphModel model(std::make_shared<NodeDelegateModelRegistry>());
+
+        CHECK_THROWS_AS(model.loadBinary(data), std::runtime_error);
+        CHECK(model.allNodeIds().empty());
+    }
+}
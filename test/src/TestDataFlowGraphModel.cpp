@@ -0,0 +1,225 @@
+#include <catch2/catch.hpp>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "ApplicationSetup.hpp"
+#include "Stringify.hpp"
+#include "StubNodeDelegateModel.hpp"
+
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/DataFlowGraphicsScene>
+#include <QtNodes/NodeDelegateModelRegistry>
+#include <QtNodes/UndoCommands>
+
+#include <QUndoStack>
+
+using QtNodes::ConnectCommand;
+using QtNodes::ConnectionId;
+using QtNodes::DataFlowGraphicsScene;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::DisconnectCommand;
+using QtNodes::InvalidNodeId;
+using QtNodes::InvalidPortIndex;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::NodeId;
+using QtNodes::PortType;
+
+TEST_CASE("DataFlowGraphModel triggers connections created or deleted", "[gui]")
+{
+    struct MockDataModel : StubNodeDelegateModel
+    {
+        unsigned int nPorts(PortType) const override { return 1; }
+
+        void inputConnectionCreated(ConnectionId const &) override { inputCreatedCalledCount++; }
+
+        void inputConnectionDeleted(ConnectionId const &) override { inputDeletedCalledCount++; }
+
+        void outputConnectionCreated(ConnectionId const &) override { outputCreatedCalledCount++; }
+
+        void outputConnectionDeleted(ConnectionId const &) override { outputDeletedCalledCount++; }
+
+        int inputCreatedCalledCount = 0;
+        int inputDeletedCalledCount = 0;
+        int outputCreatedCalledCount = 0;
+        int outputDeletedCalledCount = 0;
+
+        void resetCallCounts()
+        {
+            inputCreatedCalledCount = 0;
+            inputDeletedCalledCount = 0;
+            outputCreatedCalledCount = 0;
+            outputDeletedCalledCount = 0;
+        }
+    };
+
+    auto setup = applicationSetup();
+
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<MockDataModel>();
+
+    DataFlowGraphModel graphModel(registry);
+    DataFlowGraphicsScene scene(graphModel);
+
+    NodeId const fromNode = graphModel.addNode("name");
+    NodeId const toNode = graphModel.addNode("name");
+    NodeId const unrelatedNode = graphModel.addNode("name");
+
+    graphModel.setNodeData(fromNode, QtNodes::NodeRole::Position, QPointF(0, 0));
+    graphModel.setNodeData(toNode, QtNodes::NodeRole::Position, QPointF(200, 20));
+    graphModel.setNodeData(unrelatedNode, QtNodes::NodeRole::Position, QPointF(-100, -100));
+
+    auto &from = *graphModel.delegateModel<MockDataModel>(fromNode);
+    auto &to = *graphModel.delegateModel<MockDataModel>(toNode);
+    auto &unrelated = *graphModel.delegateModel<MockDataModel>(unrelatedNode);
+
+    ConnectionId const connectionId{fromNode, 0, toNode, 0};
+
+    SECTION("creating half a connection (not finishing the connection)")
+    {
+        scene.makeDraftConnection(ConnectionId{fromNode, 0, InvalidNodeId, InvalidPortIndex});
+
+        CHECK(from.inputCreatedCalledCount == 0);
+        CHECK(from.outputCreatedCalledCount == 0);
+
+        CHECK(to.inputCreatedCalledCount == 0);
+        CHECK(to.outputCreatedCalledCount == 0);
+
+        CHECK(unrelated.inputCreatedCalledCount == 0);
+        CHECK(unrelated.outputCreatedCalledCount == 0);
+
+        scene.resetDraftConnection();
+    }
+
+    struct Creation
+    {
+        std::string name;
+        std::function<void()> createConnection;
+    };
+
+    Creation modelCreation{"graphModel.addConnection",
+                           [&] { graphModel.addConnection(connectionId); }};
+
+    Creation commandCreation{"ConnectCommand", [&] {
+                                 scene.undoStack().push(new ConnectCommand(&scene, connectionId));
+                             }};
+
+    struct Deletion
+    {
+        std::string name;
+        std::function<void()> deleteConnection;
+    };
+
+    Deletion modelDeletion{"graphModel.deleteConnection",
+                           [&] { graphModel.deleteConnection(connectionId); }};
+
+    Deletion commandDeletion{"DisconnectCommand", [&] {
+                                 scene.undoStack().push(
+                                     new DisconnectCommand(&scene, connectionId));
+                             }};
+
+    SECTION("creating a connection")
+    {
+        std::vector<Creation> cases({modelCreation, commandCreation});
+
+        for (Creation const &create : cases) {
+            SECTION(create.name)
+            {
+                create.createConnection();
+
+                CHECK(from.inputCreatedCalledCount == 0);
+                CHECK(from.outputCreatedCalledCount == 1);
+
+                CHECK(to.inputCreatedCalledCount == 1);
+                CHECK(to.outputCreatedCalledCount == 0);
+
+                CHECK(unrelated.inputCreatedCalledCount == 0);
+                CHECK(unrelated.outputCreatedCalledCount == 0);
+
+                graphModel.deleteConnection(connectionId);
+            }
+        }
+    }
+
+    SECTION("deleting a connection")
+    {
+        std::vector<Deletion> cases({modelDeletion, commandDeletion});
+
+        for (auto const &deletion : cases) {
+            SECTION("deletion: " + deletion.name)
+            {
+                modelCreation.createConnection();
+
+                from.resetCallCounts();
+                to.resetCallCounts();
+
+                deletion.deleteConnection();
+
+                CHECK(from.inputDeletedCalledCount == 0);
+                CHECK(from.outputDeletedCalledCount == 1);
+
+                CHECK(to.inputDeletedCalledCount == 1);
+                CHECK(to.outputDeletedCalledCount == 0);
+
+                CHECK(unrelated.inputDeletedCalledCount == 0);
+                CHECK(unrelated.outputDeletedCalledCount == 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("DataFlowGraphModel's NodeDelegateModelRegistry outlives nodes and connections",
+          "[asan][gui]")
+{
+    class MockDataModel : public StubNodeDelegateModel
+    {
+    public:
+        MockDataModel(int *const &incrementOnDestruction)
+            : incrementOnDestruction(incrementOnDestruction)
+        {}
+
+        ~MockDataModel() { (*incrementOnDestruction)++; }
+
+        // The reference ensures that we point into the memory that would be free'd
+        // if the NodeDelegateModelRegistry doesn't outlive this node
+        int *const &incrementOnDestruction;
+    };
+
+    struct MockDataModelCreator
+    {
+        MockDataModelCreator(int *shouldBeAliveWhenAssignedTo)
+            : shouldBeAliveWhenAssignedTo(shouldBeAliveWhenAssignedTo)
+        {}
+
+        std::unique_ptr<MockDataModel> operator()() const
+        {
+            return std::make_unique<MockDataModel>(shouldBeAliveWhenAssignedTo);
+        }
+
+        int *shouldBeAliveWhenAssignedTo;
+    };
+
+    int modelsDestroyed = 0;
+
+    // Introduce a new scope, so that modelsDestroyed will be alive even after the
+    // DataFlowGraphModel is destroyed.
+    {
+        auto setup = applicationSetup();
+
+        auto registry = std::make_shared<NodeDelegateModelRegistry>();
+        registry->registerModel<MockDataModel>(MockDataModelCreator(&modelsDestroyed));
+
+        modelsDestroyed = 0;
+
+        DataFlowGraphModel graphModel(std::move(registry));
+
+        graphModel.addNode("name");
+
+        // On destruction, if this node outlives its MockDataModelCreator,
+        // (if it outlives the NodeDelegateModelRegistry), then we trigger undefined
+        // behavior through use-after-free. ASAN will catch that.
+    }
+
+    CHECK(modelsDestroyed == 1);
+}
@@ -2,41 +2,42 @@
 
 #include "ApplicationSetup.hpp"
 #include "Stringify.hpp"
-#include "StubNodeDataModel.hpp"
+#include "StubNodeDelegateModel.hpp"
 
-#include <QtNodes/Connection>
-#include <QtNodes/FlowScene>
-#include <QtNodes/FlowView>
-#include <QtNodes/Node>
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/DataFlowGraphicsScene>
+#include <QtNodes/GraphicsView>
+#include <QtNodes/NodeDelegateModelRegistry>
+#include <QtNodes/internal/NodeGraphicsObject.hpp>
 #include <QtTest>
 #include <QtWidgets/QApplication>
 
-using QtNodes::Connection;
-using QtNodes::DataModelRegistry;
-using QtNodes::FlowScene;
-using QtNodes::FlowView;
-using QtNodes::Node;
-using QtNodes::NodeData;
-using QtNodes::NodeDataModel;
-using QtNodes::NodeDataType;
-using QtNodes::PortIndex;
-using QtNodes::PortType;
+using QtNodes::DataFlowGraphicsScene;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::GraphicsView;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::NodeGraphicsObject;
+using QtNodes::NodeId;
 
 TEST_CASE("Dragging node changes position", "[gui]")
 {
     auto app = applicationSetup();
 
-    FlowScene scene;
-    FlowView view(&scene);
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<StubNodeDelegateModel>();
+
+    DataFlowGraphModel graphModel(registry);
+    DataFlowGraphicsScene scene(graphModel);
+    GraphicsView view(&scene);
 
     view.show();
     REQUIRE(QTest::qWaitForWindowExposed(&view));
 
     SECTION("just one node")
     {
-        auto &node = scene.createNode(std::make_unique<StubNodeDataModel>());
+        NodeId const nodeId = graphModel.addNode("name");
 
-        auto &ngo = node.nodeGraphicsObject();
+        NodeGraphicsObject &ngo = *scene.nodeGraphicsObject(nodeId);
 
         QPointF scPosBefore = ngo.pos();
 
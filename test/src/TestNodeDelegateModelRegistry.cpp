@@ -1,31 +1,31 @@
 #include <catch2/catch.hpp>
 
-#include "StubNodeDataModel.hpp"
+#include "StubNodeDelegateModel.hpp"
 
-#include <QtNodes/DataModelRegistry>
+#include <QtNodes/NodeDelegateModelRegistry>
 
-using QtNodes::DataModelRegistry;
 using QtNodes::NodeData;
-using QtNodes::NodeDataModel;
 using QtNodes::NodeDataType;
+using QtNodes::NodeDelegateModel;
+using QtNodes::NodeDelegateModelRegistry;
 using QtNodes::PortIndex;
 using QtNodes::PortType;
 
 namespace {
-class StubModelStaticName : public StubNodeDataModel
+class StubModelStaticName : public StubNodeDelegateModel
 {
 public:
     static QString Name() { return "Name"; }
 };
 } // namespace
 
-TEST_CASE("DataModelRegistry::registerModel", "[interface]")
+TEST_CASE("NodeDelegateModelRegistry::registerModel", "[interface]")
 {
-    DataModelRegistry registry;
+    NodeDelegateModelRegistry registry;
 
     SECTION("stub model")
     {
-        registry.registerModel<StubNodeDataModel>();
+        registry.registerModel<StubNodeDelegateModel>();
         auto model = registry.create("name");
 
         CHECK(model->name() == "name");
@@ -41,17 +41,19 @@ TEST_CASE("DataModelRegistry::registerModel", "[interface]")
     {
         SECTION("non-static name()")
         {
-            registry.registerModel([] { return std::make_unique<StubNodeDataModel>(); });
+            registry.registerModel<StubNodeDelegateModel>(
+                [] { return std::make_unique<StubNodeDelegateModel>(); });
 
             auto model = registry.create("name");
 
             REQUIRE(model != nullptr);
             CHECK(model->name() == "name");
-            CHECK(dynamic_cast<StubNodeDataModel *>(model.get()));
+            CHECK(dynamic_cast<StubNodeDelegateModel *>(model.get()));
         }
         SECTION("static Name()")
         {
-            registry.registerModel([] { return std::make_unique<StubModelStaticName>(); });
+            registry.registerModel<StubModelStaticName>(
+                [] { return std::make_unique<StubModelStaticName>(); });
 
             auto model = registry.create("Name");
 
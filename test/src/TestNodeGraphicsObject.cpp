@@ -1,34 +1,41 @@
 #include <catch2/catch.hpp>
 
 #include "ApplicationSetup.hpp"
-#include "StubNodeDataModel.hpp"
+#include "StubNodeDelegateModel.hpp"
 
-#include <QtNodes/FlowScene>
-#include <QtNodes/FlowView>
-#include <QtNodes/Node>
-#include <QtNodes/NodeDataModel>
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/DataFlowGraphicsScene>
+#include <QtNodes/GraphicsView>
+#include <QtNodes/NodeDelegateModelRegistry>
+#include <QtNodes/internal/NodeGraphicsObject.hpp>
 #include <QtTest>
 
-using QtNodes::FlowScene;
-using QtNodes::FlowView;
-using QtNodes::Node;
-using QtNodes::NodeDataModel;
+using QtNodes::ConnectionPolicy;
+using QtNodes::DataFlowGraphicsScene;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::GraphicsView;
+using QtNodes::NodeDelegateModelRegistry;
 using QtNodes::NodeGraphicsObject;
+using QtNodes::NodeId;
+using QtNodes::NodeRole;
+using QtNodes::PortIndex;
 using QtNodes::PortType;
 
-TEST_CASE("NodeDataModel::portOutConnectionPolicy(...) isn't called for input "
-          "connections (issue #127)",
+TEST_CASE("NodeDelegateModel::portConnectionPolicy(...) isn't called for output ports "
+          "by input connections (issue #127)",
           "[gui]")
 {
-    class MockModel : public StubNodeDataModel
+    class MockModel : public StubNodeDelegateModel
     {
     public:
         unsigned int nPorts(PortType) const override { return 1; }
 
-        NodeDataModel::ConnectionPolicy portOutConnectionPolicy(int index) const override
+        ConnectionPolicy portConnectionPolicy(PortType portType, PortIndex) const override
         {
-            portOutConnectionPolicyCalledCount++;
-            return NodeDataModel::ConnectionPolicy::One;
+            if (portType == PortType::Out)
+                portOutConnectionPolicyCalledCount++;
+
+            return ConnectionPolicy::One;
         }
 
         mutable int portOutConnectionPolicyCalledCount = 0;
@@ -36,8 +43,12 @@ TEST_CASE("NodeDataModel::portOutConnectionPolicy(...) isn't called for input "
 
     auto setup = applicationSetup();
 
-    FlowScene scene;
-    FlowView view(&scene);
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<MockModel>();
+
+    DataFlowGraphModel graphModel(registry);
+    DataFlowGraphicsScene scene(graphModel);
+    GraphicsView view(&scene);
 
     // Ensure we have enough size to contain the node
     view.resize(640, 480);
@@ -45,16 +56,21 @@ TEST_CASE("NodeDataModel::portOutConnectionPolicy(...) isn't called for input "
     view.show();
     REQUIRE(QTest::qWaitForWindowExposed(&view));
 
-    auto &node = scene.createNode(std::make_unique<MockModel>());
-    auto &model = dynamic_cast<MockModel &>(*node.nodeDataModel());
-    auto &ngo = node.nodeGraphicsObject();
-    auto &ngeom = node.nodeGeometry();
+    NodeId const nodeId = graphModel.addNode("name");
+    auto &model = *graphModel.delegateModel<MockModel>(nodeId);
+    NodeGraphicsObject &ngo = *scene.nodeGraphicsObject(nodeId);
 
     // Move the node to somewhere in the middle of the screen
-    ngo.setPos(QPointF(50, 50));
+    graphModel.setNodeData(nodeId, NodeRole::Position, QPointF(50, 50));
+
+    // The policies of all the ports are read when the node is created.
+    model.portOutConnectionPolicyCalledCount = 0;
 
     // Compute the on-screen position of the input port
-    QPointF scInPortPos = ngeom.portScenePosition(0, PortType::In, ngo.sceneTransform());
+    QPointF scInPortPos = scene.nodeGeometry().portScenePosition(nodeId,
+                                                                 PortType::In,
+                                                                 0,
+                                                                 ngo.sceneTransform());
     QPoint vwInPortPos = view.mapFromScene(scInPortPos);
 
     // Create a partial connection by clicking on the input port of the node
@@ -0,0 +1,297 @@
+#include <catch2/catch.hpp>
+
+#include <QtNodes/internal/NodeSpatialIndex.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <vector>
+
+using QtNodes::NodeId;
+using QtNodes::NodeSpatialIndex;
+
+namespace QtNodes {
+
+struct NodeSpatialIndexTestAccess
+{
+    static void setStamp(NodeSpatialIndex const &index, unsigned int const stamp)
+    {
+        index._stamp = stamp;
+    }
+};
+
+} // namespace QtNodes
+
+using QtNodes::NodeSpatialIndexTestAccess;
+
+namespace {
+
+/// The rectangles last given to the index, queried by brute force.
+using Rects = std::map<NodeId, QRectF>;
+
+void update(NodeSpatialIndex &index, Rects &rects, NodeId const nodeId, QRectF const &rect)
+{
+    index.update(nodeId, rect);
+    rects[nodeId] = rect;
+}
+
+std::vector<NodeId> sorted(std::vector<NodeId> ids)
+{
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+std::vector<NodeId> query(NodeSpatialIndex const &index, QRectF const &rect)
+{
+    std::vector<NodeId> result;
+    index.query(rect, result);
+    return sorted(result);
+}
+
+std::vector<NodeId> query(NodeSpatialIndex const &index, QPointF const &point)
+{
+    std::vector<NodeId> result;
+    index.query(point, result);
+    return sorted(result);
+}
+
+std::vector<NodeId> expected(Rects const &rects, QRectF const &rect)
+{
+    std::vector<NodeId> result;
+    for (auto const &r : rects) {
+        if (r.second.intersects(rect))
+            result.push_back(r.first);
+    }
+    return result;
+}
+
+std::vector<NodeId> expected(Rects const &rects, QPointF const &point)
+{
+    std::vector<NodeId> result;
+    for (auto const &r : rects) {
+        if (r.second.contains(point))
+            result.push_back(r.first);
+    }
+    return result;
+}
+
+/// A 20x20 grid of nodes with cells of 100; every third node spans four cells.
+void populateGrid(NodeSpatialIndex &index, Rects &rects)
+{
+    NodeId nodeId = 0;
+
+    for (int i = 0; i < 20; ++i) {
+        for (int j = 0; j < 20; ++j) {
+            qreal const size = (nodeId % 3 == 0) ? 150.0 : 60.0;
+
+            update(index, rects, nodeId++, QRectF(i * 100.0 + 20.0, j * 100.0 + 20.0, size, size));
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("Spatial index point and rectangle queries", "[index]")
+{
+    NodeSpatialIndex index(100.0);
+    Rects rects;
+
+    populateGrid(index, rects);
+
+    REQUIRE(index.size() == rects.size());
+
+    SECTION("Points")
+    {
+        for (QPointF const point : {QPointF(25.0, 25.0),
+                                    QPointF(150.0, 150.0),
+                                    QPointF(95.0, 95.0),
+                                    QPointF(-5.0, -5.0),
+                                    QPointF(1990.0, 1990.0),
+                                    QPointF(2500.0, 10.0)}) {
+            CAPTURE(point.x(), point.y());
+            CHECK(query(index, point) == expected(rects, point));
+        }
+    }
+
+    SECTION("Rectangles report each node once")
+    {
+        for (QRectF const rect : {QRectF(0.0, 0.0, 10.0, 10.0),
+                                  QRectF(150.0, 150.0, 300.0, 120.0),
+                                  QRectF(990.0, 10.0, 30.0, 1500.0),
+                                  QRectF(-500.0, -500.0, 530.0, 530.0),
+                                  QRectF(380.0, 380.0, -200.0, -200.0)}) {
+            CAPTURE(rect.x(), rect.y(), rect.width(), rect.height());
+
+            std::vector<NodeId> result;
+            index.query(rect, result);
+
+            CHECK(sorted(result) == expected(rects, rect.normalized()));
+        }
+    }
+
+    SECTION("Queries larger than the populated area")
+    {
+        QRectF const everything(-1e6, -1e6, 2e6, 2e6);
+
+        CHECK(query(index, everything).size() == rects.size());
+    }
+
+    SECTION("Cell size changes keep the results")
+    {
+        index.setCellSize(37.0);
+
+        QRectF const rect(150.0, 150.0, 300.0, 120.0);
+
+        CHECK(query(index, rect) == expected(rects, rect));
+        CHECK(query(index, QPointF(150.0, 150.0)) == expected(rects, QPointF(150.0, 150.0)));
+    }
+}
+
+TEST_CASE("Spatial index follows moved and removed nodes", "[index]")
+{
+    NodeSpatialIndex index(100.0);
+    Rects rects;
+
+    populateGrid(index, rects);
+
+    NodeId const moved = 1;
+    QRectF const oldRect = rects[moved];
+
+    SECTION("Move across cells")
+    {
+        update(index, rects, moved, QRectF(5020.0, -3010.0, 60.0, 60.0));
+
+        CHECK(query(index, oldRect.center()) == expected(rects, oldRect.center()));
+        CHECK(query(index, QPointF(5050.0, -2980.0)) == std::vector<NodeId>{moved});
+        CHECK(query(index, QRectF(5000.0, -3050.0, 200.0, 200.0)) == std::vector<NodeId>{moved});
+    }
+
+    SECTION("Move within the same cells")
+    {
+        // Shrinks the node away from its old bottom right corner.
+        update(index, rects, moved, oldRect.adjusted(0.0, 0.0, -40.0, -40.0));
+
+        QPointF const corner = oldRect.bottomRight() - QPointF(1.0, 1.0);
+
+        CHECK(query(index, corner) == expected(rects, corner));
+        CHECK(query(index, oldRect) == expected(rects, oldRect));
+    }
+
+    SECTION("Remove")
+    {
+        index.remove(moved);
+        rects.erase(moved);
+
+        CHECK(index.size() == rects.size());
+        CHECK(query(index, oldRect.center()) == expected(rects, oldRect.center()));
+        CHECK(query(index, oldRect) == expected(rects, oldRect));
+
+        // Removing twice is harmless.
+        index.remove(moved);
+        CHECK(index.size() == rects.size());
+    }
+
+    SECTION("Clear")
+    {
+        index.clear();
+
+        CHECK(index.size() == 0);
+        CHECK(query(index, oldRect).empty());
+        CHECK(query(index, oldRect.center()).empty());
+    }
+}
+
+TEST_CASE("Spatial index keeps oversized nodes aside", "[index]")
+{
+    NodeSpatialIndex index(100.0);
+    Rects rects;
+
+    populateGrid(index, rects);
+
+    // Covers far more cells than a node is registered in individually.
+    NodeId const huge = 10000;
+    update(index, rects, huge, QRectF(-1e5, -1e5, 2e5, 2e5));
+
+    SECTION("Queries")
+    {
+        QRectF const rect(150.0, 150.0, 300.0, 120.0);
+        std::vector<NodeId> result;
+        index.query(rect, result);
+
+        CHECK(std::count(result.begin(), result.end(), huge) == 1);
+        CHECK(sorted(result) == expected(rects, rect));
+
+        CHECK(query(index, QPointF(150.0, 150.0)) == expected(rects, QPointF(150.0, 150.0)));
+        CHECK(query(index, QPointF(-5e4, 5e4)) == std::vector<NodeId>{huge});
+    }
+
+    SECTION("Shrinking back into cells")
+    {
+        update(index, rects, huge, QRectF(-500.0, -500.0, 50.0, 50.0));
+
+        CHECK(query(index, QPointF(-5e4, 5e4)).empty());
+        CHECK(query(index, QPointF(-480.0, -480.0)) == std::vector<NodeId>{huge});
+
+        QRectF const rect(150.0, 150.0, 300.0, 120.0);
+        CHECK(query(index, rect) == expected(rects, rect));
+    }
+
+    SECTION("Remove")
+    {
+        index.remove(huge);
+        rects.erase(huge);
+
+        CHECK(query(index, QPointF(-5e4, 5e4)).empty());
+        CHECK(index.size() == rects.size());
+    }
+
+    SECTION("Huge coordinates")
+    {
+        update(index, rects, huge, QRectF(-1e300, -1e300, 1e300, 2e300));
+
+        CHECK(query(index, QPointF(-1e200, 0.0)) == std::vector<NodeId>{huge});
+    }
+}
+
+TEST_CASE("Spatial index survives the query stamp wraparound", "[index]")
+{
+    NodeSpatialIndex index(100.0);
+    Rects rects;
+
+    populateGrid(index, rects);
+
+    // Nodes spanning several cells are deduplicated through the stamps.
+    QRectF const rect(150.0, 150.0, 300.0, 300.0);
+    REQUIRE(expected(rects, rect).size() > 4);
+
+    // New nodes start with the stamp the counter wraps around to.
+    update(index, rects, 20000, QRectF(260.0, 260.0, 150.0, 150.0));
+    std::vector<NodeId> const withNew = expected(rects, rect);
+
+    SECTION("Wrapping query")
+    {
+        // None of the nodes has been reported yet, their stamps are all zero.
+        NodeSpatialIndexTestAccess::setStamp(index, std::numeric_limits<unsigned int>::max());
+
+        CHECK(query(index, rect) == withNew);
+    }
+
+    SECTION("Queries around the wraparound")
+    {
+        NodeSpatialIndexTestAccess::setStamp(index, std::numeric_limits<unsigned int>::max() - 3);
+
+        for (int i = 0; i < 8; ++i) {
+            CAPTURE(i);
+
+            // Reported nodes keep stamps from before the wraparound.
+            if (i == 2)
+                update(index, rects, 20001, QRectF(180.0, 380.0, 150.0, 150.0));
+
+            std::vector<NodeId> result;
+            index.query(rect, result);
+
+            CHECK(sorted(result) == expected(rects, rect));
+            CHECK(result.size() == expected(rects, rect).size());
+        }
+    }
+}
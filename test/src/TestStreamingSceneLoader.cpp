@@ -0,0 +1,148 @@
+#include <catch2/catch.hpp>
+
+#include "ApplicationSetup.hpp"
+#include "TaggedModel.hpp"
+
+#include <QtNodes/ConnectionIdUtils>
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/NodeDelegateModelRegistry>
+#include <QtNodes/internal/StreamingSceneLoader.hpp>
+
+#include <QtCore/QBuffer>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+
+#include <memory>
+
+using QtNodes::ConnectionId;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::NodeId;
+using QtNodes::StreamingSceneLoader;
+
+namespace {
+
+QJsonObject sceneJson(int const nodeCount)
+{
+    QJsonArray nodes;
+
+    for (int i = 0; i < nodeCount; ++i) {
+        QJsonObject internalData;
+        internalData["model-name"] = TaggedModel::Name();
+        // Brackets, braces and escapes inside strings must not confuse the scanner.
+        internalData["tag"] = QStringLiteral("node %1 {\"nodes\": [%1]} \\ ]}").arg(i);
+
+        nodes.append(nodeJson(static_cast<NodeId>(3 * i + 1),
+                              internalData,
+                              QPointF(30.0 * i, -12.5 * i)));
+    }
+
+    QJsonArray connections;
+
+    for (int i = 0; i + 1 < nodeCount; ++i) {
+        NodeId const out = static_cast<NodeId>(3 * i + 1);
+        NodeId const in = static_cast<NodeId>(3 * (i + 1) + 1);
+
+        connections.append(QtNodes::toJson(ConnectionId{out, 0, in, 0}));
+    }
+
+    QJsonObject scene;
+    // Unknown keys before the arrays are skipped.
+    scene["comment"] = QStringLiteral("\"connections\": [{}]");
+    scene["connections"] = connections;
+    scene["nodes"] = nodes;
+
+    return scene;
+}
+
+/// @returns the error string of the loader, empty on success.
+QString streamLoad(DataFlowGraphModel &model,
+                   QByteArray bytes,
+                   qint64 const chunkSize = 1 << 16,
+                   bool const concurrent = false)
+{
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+
+    StreamingSceneLoader loader(model);
+    loader.setChunkSize(chunkSize);
+    loader.setConcurrent(concurrent);
+    // Several batches, the last one partial.
+    loader.setStepSize(15);
+
+    if (loader.load(buffer))
+        return QString();
+
+    return loader.errorString().isEmpty() ? QStringLiteral("unknown error")
+                                          : loader.errorString();
+}
+
+void checkSameGraph(DataFlowGraphModel const &expected, DataFlowGraphModel const &actual)
+{
+    REQUIRE(actual.allNodeIds() == expected.allNodeIds());
+
+    for (NodeId const nodeId : expected.allNodeIds()) {
+        CHECK(actual.saveNode(nodeId) == expected.saveNode(nodeId));
+        CHECK(actual.allConnectionIds(nodeId) == expected.allConnectionIds(nodeId));
+    }
+}
+
+} // namespace
+
+TEST_CASE("Streaming loader matches DataFlowGraphModel::load()", "[streaming]")
+{
+    auto setup = applicationSetup();
+
+    QJsonObject const scene = sceneJson(40);
+
+    DataFlowGraphModel expected(taggedRegistry());
+    expected.load(scene);
+
+    REQUIRE(expected.allNodeIds().size() == 40);
+
+    auto format = GENERATE(QJsonDocument::Indented, QJsonDocument::Compact);
+    auto chunkSize = GENERATE(as<qint64>{}, 1, 7, 1 << 16);
+    auto concurrent = GENERATE(false, true);
+
+    CAPTURE(chunkSize, concurrent);
+
+    DataFlowGraphModel actual(taggedRegistry());
+
+    QString const error = streamLoad(actual,
+                                     QJsonDocument(scene).toJson(format),
+                                     chunkSize,
+                                     concurrent);
+
+    INFO(error.toStdString());
+    REQUIRE(error.isEmpty());
+
+    checkSameGraph(expected, actual);
+}
+
+TEST_CASE("Streaming loader reports malformed scenes", "[streaming]")
+{
+    auto setup = applicationSetup();
+
+    QByteArray const bytes = QJsonDocument(sceneJson(5)).toJson(QJsonDocument::Compact);
+
+    auto concurrent = GENERATE(false, true);
+
+    CAPTURE(concurrent);
+
+    SECTION("Truncated document")
+    {
+        DataFlowGraphModel model(taggedRegistry());
+
+        QByteArray const truncated = bytes.left(bytes.size() - 10);
+
+        CHECK_FALSE(streamLoad(model, truncated, 1 << 16, concurrent).isEmpty());
+    }
+
+    SECTION("Unknown node model")
+    {
+        DataFlowGraphModel model(std::make_shared<NodeDelegateModelRegistry>());
+
+        CHECK_FALSE(streamLoad(model, bytes, 1 << 16, concurrent).isEmpty());
+        CHECK(model.allNodeIds().empty());
+    }
+}
@@ -0,0 +1,153 @@
+#include <catch2/catch.hpp>
+
+#include "ApplicationSetup.hpp"
+#include "TaggedModel.hpp"
+
+#include <QtNodes/BasicGraphicsScene>
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/UndoCommands>
+#include <QtNodes/internal/NodeGraphicsObject.hpp>
+
+#include <QUndoStack>
+
+#include <vector>
+
+using QtNodes::BasicGraphicsScene;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::DeleteCommand;
+using QtNodes::NodeId;
+
+namespace {
+
+/// Distinct tags of one length below the compression threshold, so every
+/// deleted node retains the same amount of undo data.
+QString tag(int const seed)
+{
+    QString ret;
+    ret.reserve(900);
+
+    unsigned int state = 2166136261u ^ static_cast<unsigned int>(seed);
+    for (int i = 0; i < 900; ++i) {
+        state = state * 1664525u + 1013904223u;
+        ret.append(QChar('a' + static_cast<int>((state >> 16) % 26)));
+    }
+
+    return ret;
+}
+
+NodeId addTaggedNode(DataFlowGraphModel &model, QString const &nodeTag)
+{
+    NodeId const nodeId = model.addNode(TaggedModel::Name());
+    model.delegateModel<TaggedModel>(nodeId)->tag = nodeTag;
+    return nodeId;
+}
+
+void deleteNode(BasicGraphicsScene &scene, NodeId const nodeId)
+{
+    scene.clearSelection();
+    scene.nodeGraphicsObject(nodeId)->setSelected(true);
+
+    scene.undoStack().push(new DeleteCommand(&scene));
+}
+
+/// Undoes until the stack is exhausted, discarded commands do not count.
+int undoDepth(QUndoStack &undoStack)
+{
+    int depth = 0;
+
+    while (undoStack.canUndo()) {
+        undoStack.undo();
+        ++depth;
+    }
+
+    return depth;
+}
+
+} // namespace
+
+TEST_CASE("Undo history is kept within the memory budget", "[undo]")
+{
+    auto setup = applicationSetup();
+
+    DataFlowGraphModel model(taggedRegistry());
+    BasicGraphicsScene scene(model);
+
+    std::vector<NodeId> nodeIds;
+    for (int i = 0; i < 10; ++i) {
+        nodeIds.push_back(addTaggedNode(model, tag(i)));
+    }
+
+    deleteNode(scene, nodeIds[0]);
+
+    std::size_t const commandUsage = scene.undoMemoryUsage();
+    REQUIRE(commandUsage > 900);
+
+    SECTION("Oldest commands are discarded")
+    {
+        std::size_t const budget = 3 * commandUsage + commandUsage / 2;
+        scene.setUndoMemoryBudget(budget);
+
+        for (std::size_t i = 1; i < nodeIds.size(); ++i) {
+            deleteNode(scene, nodeIds[i]);
+
+            CHECK(scene.undoMemoryUsage() <= budget);
+        }
+
+        REQUIRE(model.allNodeIds().empty());
+
+        CHECK(undoDepth(scene.undoStack()) == 3);
+
+        // Only the three most recent deletions were undone.
+        CHECK(model.allNodeIds().size() == 3);
+        CHECK(model.nodeExists(nodeIds[7]));
+        CHECK(model.nodeExists(nodeIds[8]));
+        CHECK(model.nodeExists(nodeIds[9]));
+    }
+
+    SECTION("The most recent command is always kept")
+    {
+        scene.setUndoMemoryBudget(1);
+
+        for (std::size_t i = 1; i < nodeIds.size(); ++i) {
+            deleteNode(scene, nodeIds[i]);
+        }
+
+        CHECK(undoDepth(scene.undoStack()) == 1);
+        CHECK(model.allNodeIds().size() == 1);
+        CHECK(model.nodeExists(nodeIds.back()));
+    }
+
+    SECTION("Unlimited budget keeps everything")
+    {
+        for (std::size_t i = 1; i < nodeIds.size(); ++i) {
+            deleteNode(scene, nodeIds[i]);
+        }
+
+        CHECK(scene.undoMemoryUsage() >= nodeIds.size() * commandUsage * 9 / 10);
+        CHECK(undoDepth(scene.undoStack()) == static_cast<int>(nodeIds.size()));
+        CHECK(model.allNodeIds().size() == nodeIds.size());
+    }
+}
+
+TEST_CASE("Node states are shared within one scene only", "[undo]")
+{
+    auto setup = applicationSetup();
+
+    DataFlowGraphModel firstModel(taggedRegistry());
+    BasicGraphicsScene firstScene(firstModel);
+
+    DataFlowGraphModel secondModel(taggedRegistry());
+    BasicGraphicsScene secondScene(secondModel);
+
+    // Equal states apart from the node ids, which are not part of the state.
+    deleteNode(firstScene, addTaggedNode(firstModel, tag(1)));
+    deleteNode(firstScene, addTaggedNode(firstModel, tag(1)));
+
+    CHECK(firstScene.nodeStatePool().size() == 1);
+    CHECK(secondScene.nodeStatePool().size() == 0);
+
+    deleteNode(secondScene, addTaggedNode(secondModel, tag(1)));
+
+    CHECK(firstScene.nodeStatePool().size() == 1);
+    CHECK(secondScene.nodeStatePool().size() == 1);
+}